@@ -0,0 +1,542 @@
+#include "Capture.h"
+#include "CaptureFormat.h"
+#include "Extensions.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <vector>
+
+#define CAPTURED_CALLS(X) \
+	X(Clear) X(ClearColor) X(Viewport) X(Enable) X(Disable) X(BlendFunc) X(DepthFunc) X(PixelStorei) \
+	X(ActiveTexture) X(GenTextures) X(DeleteTextures) X(BindTexture) X(TexParameteri) X(TexImage2D) \
+	X(TexSubImage2D) X(GenerateMipmap) \
+	X(GenBuffers) X(DeleteBuffers) X(BindBuffer) X(BufferData) X(BufferSubData) X(BindBufferRange) \
+	X(BindBufferBase) X(MapBufferRange) X(UnmapBuffer) \
+	X(GenVertexArrays) X(DeleteVertexArrays) X(BindVertexArray) X(VertexAttribPointer) \
+	X(VertexAttribIPointer) X(EnableVertexAttribArray) X(DisableVertexAttribArray) X(VertexAttribDivisor) \
+	X(CreateShader) X(ShaderSource) X(CompileShader) X(DeleteShader) X(CreateProgram) X(AttachShader) \
+	X(DetachShader) X(LinkProgram) X(DeleteProgram) X(UseProgram) X(GetUniformLocation) \
+	X(Uniform1i) X(Uniform1f) X(Uniform2f) X(Uniform3f) X(Uniform4f) X(Uniform1iv) X(Uniform1fv) \
+	X(Uniform2fv) X(Uniform3fv) X(Uniform4fv) X(UniformMatrix3fv) X(UniformMatrix4fv) \
+	X(DrawArrays) X(DrawElements) X(DrawArraysInstanced) X(DrawElementsInstanced) X(DrawElementsBaseVertex) \
+	X(MultiDrawElementsBaseVertex) \
+	X(GenFramebuffers) X(DeleteFramebuffers) X(BindFramebuffer) X(FramebufferTexture2D) \
+	X(FramebufferRenderbuffer) X(GenRenderbuffers) X(DeleteRenderbuffers) X(BindRenderbuffer) \
+	X(RenderbufferStorage) X(BlitFramebuffer)
+
+#define DECLARE_REAL(name) decltype(glad_gl##name) real##name;
+CAPTURED_CALLS(DECLARE_REAL)
+
+std::ofstream captureFile;
+int framesLeft = 0;
+GLint unpackAlignment = 4;
+
+struct Mapping {
+	GLintptr offset;
+	GLsizeiptr length;
+	GLbitfield access;
+	void* data;
+};
+
+std::map<GLenum, Mapping> mappings;
+
+template <typename T>
+void put(const T& value) {
+	captureFile.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void putBlob(const void* data, uint64_t size) {
+	put(size);
+	if (size) {
+		captureFile.write(static_cast<const char*>(data), size);
+	}
+}
+
+template <typename... Args>
+void record(CaptureOp op, const Args&... args) {
+	put(op);
+	int order[] = { 0, (put(args), 0)... };
+	(void)order;
+}
+
+uint64_t offset(const void* pointer) {
+	return uint64_t(uintptr_t(pointer));
+}
+
+void APIENTRY captureClear(GLbitfield mask) {
+	record(CaptureOp::Clear, mask);
+	realClear(mask);
+}
+
+void APIENTRY captureClearColor(GLfloat r, GLfloat g, GLfloat b, GLfloat a) {
+	record(CaptureOp::ClearColor, r, g, b, a);
+	realClearColor(r, g, b, a);
+}
+
+void APIENTRY captureViewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+	record(CaptureOp::Viewport, x, y, width, height);
+	realViewport(x, y, width, height);
+}
+
+void APIENTRY captureEnable(GLenum cap) {
+	record(CaptureOp::Enable, cap);
+	realEnable(cap);
+}
+
+void APIENTRY captureDisable(GLenum cap) {
+	record(CaptureOp::Disable, cap);
+	realDisable(cap);
+}
+
+void APIENTRY captureBlendFunc(GLenum source, GLenum destination) {
+	record(CaptureOp::BlendFunc, source, destination);
+	realBlendFunc(source, destination);
+}
+
+void APIENTRY captureDepthFunc(GLenum func) {
+	record(CaptureOp::DepthFunc, func);
+	realDepthFunc(func);
+}
+
+void APIENTRY capturePixelStorei(GLenum pname, GLint param) {
+	if (pname == GL_UNPACK_ALIGNMENT) {
+		unpackAlignment = param;
+	}
+	record(CaptureOp::PixelStorei, pname, param);
+	realPixelStorei(pname, param);
+}
+
+void APIENTRY captureActiveTexture(GLenum texture) {
+	record(CaptureOp::ActiveTexture, texture);
+	realActiveTexture(texture);
+}
+
+void APIENTRY captureGenTextures(GLsizei n, GLuint* textures) {
+	realGenTextures(n, textures);
+	record(CaptureOp::GenTextures, n);
+	putBlob(textures, n * sizeof(GLuint));
+}
+
+void APIENTRY captureDeleteTextures(GLsizei n, const GLuint* textures) {
+	record(CaptureOp::DeleteTextures, n);
+	putBlob(textures, n * sizeof(GLuint));
+	realDeleteTextures(n, textures);
+}
+
+void APIENTRY captureBindTexture(GLenum target, GLuint texture) {
+	record(CaptureOp::BindTexture, target, texture);
+	realBindTexture(target, texture);
+}
+
+void APIENTRY captureTexParameteri(GLenum target, GLenum pname, GLint param) {
+	record(CaptureOp::TexParameteri, target, pname, param);
+	realTexParameteri(target, pname, param);
+}
+
+void APIENTRY captureTexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height,
+	GLint border, GLenum format, GLenum type, const void* pixels) {
+	record(CaptureOp::TexImage2D, target, level, internalformat, width, height, border, format, type);
+	putBlob(pixels, pixels ? imageSize(width, height, format, type, unpackAlignment) : 0);
+	realTexImage2D(target, level, internalformat, width, height, border, format, type, pixels);
+}
+
+void APIENTRY captureTexSubImage2D(GLenum target, GLint level, GLint x, GLint y, GLsizei width, GLsizei height,
+	GLenum format, GLenum type, const void* pixels) {
+	record(CaptureOp::TexSubImage2D, target, level, x, y, width, height, format, type);
+	putBlob(pixels, pixels ? imageSize(width, height, format, type, unpackAlignment) : 0);
+	realTexSubImage2D(target, level, x, y, width, height, format, type, pixels);
+}
+
+void APIENTRY captureGenerateMipmap(GLenum target) {
+	record(CaptureOp::GenerateMipmap, target);
+	realGenerateMipmap(target);
+}
+
+void APIENTRY captureGenBuffers(GLsizei n, GLuint* buffers) {
+	realGenBuffers(n, buffers);
+	record(CaptureOp::GenBuffers, n);
+	putBlob(buffers, n * sizeof(GLuint));
+}
+
+void APIENTRY captureDeleteBuffers(GLsizei n, const GLuint* buffers) {
+	record(CaptureOp::DeleteBuffers, n);
+	putBlob(buffers, n * sizeof(GLuint));
+	realDeleteBuffers(n, buffers);
+}
+
+void APIENTRY captureBindBuffer(GLenum target, GLuint buffer) {
+	record(CaptureOp::BindBuffer, target, buffer);
+	realBindBuffer(target, buffer);
+}
+
+void APIENTRY captureBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage) {
+	record(CaptureOp::BufferData, target, int64_t(size), usage);
+	putBlob(data, data ? size : 0);
+	realBufferData(target, size, data, usage);
+}
+
+void APIENTRY captureBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data) {
+	record(CaptureOp::BufferSubData, target, int64_t(offset), int64_t(size));
+	putBlob(data, size);
+	realBufferSubData(target, offset, size, data);
+}
+
+void APIENTRY captureBindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+	record(CaptureOp::BindBufferRange, target, index, buffer, int64_t(offset), int64_t(size));
+	realBindBufferRange(target, index, buffer, offset, size);
+}
+
+void APIENTRY captureBindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+	record(CaptureOp::BindBufferBase, target, index, buffer);
+	realBindBufferBase(target, index, buffer);
+}
+
+// Writes through a mapping are recorded as a BufferSubData of the whole
+// mapped range when it is unmapped.
+void* APIENTRY captureMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) {
+	void* data = realMapBufferRange(target, offset, length, access);
+	mappings[target] = Mapping{ offset, length, access, data };
+	return data;
+}
+
+GLboolean APIENTRY captureUnmapBuffer(GLenum target) {
+	auto found = mappings.find(target);
+	if (found != mappings.end()) {
+		auto& mapping = found->second;
+		if (mapping.data && (mapping.access & GL_MAP_WRITE_BIT)) {
+			record(CaptureOp::BufferSubData, target, int64_t(mapping.offset), int64_t(mapping.length));
+			putBlob(mapping.data, mapping.length);
+		}
+		mappings.erase(found);
+	}
+	return realUnmapBuffer(target);
+}
+
+void APIENTRY captureGenVertexArrays(GLsizei n, GLuint* arrays) {
+	realGenVertexArrays(n, arrays);
+	record(CaptureOp::GenVertexArrays, n);
+	putBlob(arrays, n * sizeof(GLuint));
+}
+
+void APIENTRY captureDeleteVertexArrays(GLsizei n, const GLuint* arrays) {
+	record(CaptureOp::DeleteVertexArrays, n);
+	putBlob(arrays, n * sizeof(GLuint));
+	realDeleteVertexArrays(n, arrays);
+}
+
+void APIENTRY captureBindVertexArray(GLuint array) {
+	record(CaptureOp::BindVertexArray, array);
+	realBindVertexArray(array);
+}
+
+void APIENTRY captureVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized,
+	GLsizei stride, const void* pointer) {
+	record(CaptureOp::VertexAttribPointer, index, size, type, normalized, stride, offset(pointer));
+	realVertexAttribPointer(index, size, type, normalized, stride, pointer);
+}
+
+void APIENTRY captureVertexAttribIPointer(GLuint index, GLint size, GLenum type, GLsizei stride, const void* pointer) {
+	record(CaptureOp::VertexAttribIPointer, index, size, type, stride, offset(pointer));
+	realVertexAttribIPointer(index, size, type, stride, pointer);
+}
+
+void APIENTRY captureEnableVertexAttribArray(GLuint index) {
+	record(CaptureOp::EnableVertexAttribArray, index);
+	realEnableVertexAttribArray(index);
+}
+
+void APIENTRY captureDisableVertexAttribArray(GLuint index) {
+	record(CaptureOp::DisableVertexAttribArray, index);
+	realDisableVertexAttribArray(index);
+}
+
+void APIENTRY captureVertexAttribDivisor(GLuint index, GLuint divisor) {
+	record(CaptureOp::VertexAttribDivisor, index, divisor);
+	realVertexAttribDivisor(index, divisor);
+}
+
+GLuint APIENTRY captureCreateShader(GLenum type) {
+	GLuint shader = realCreateShader(type);
+	record(CaptureOp::CreateShader, type, shader);
+	return shader;
+}
+
+void APIENTRY captureShaderSource(GLuint shader, GLsizei count, const GLchar* const* strings, const GLint* lengths) {
+	record(CaptureOp::ShaderSource, shader, count);
+	for (GLsizei i = 0; i < count; i++) {
+		putBlob(strings[i], lengths && lengths[i] >= 0 ? lengths[i] : std::strlen(strings[i]));
+	}
+	realShaderSource(shader, count, strings, lengths);
+}
+
+void APIENTRY captureCompileShader(GLuint shader) {
+	record(CaptureOp::CompileShader, shader);
+	realCompileShader(shader);
+}
+
+void APIENTRY captureDeleteShader(GLuint shader) {
+	record(CaptureOp::DeleteShader, shader);
+	realDeleteShader(shader);
+}
+
+GLuint APIENTRY captureCreateProgram() {
+	GLuint program = realCreateProgram();
+	record(CaptureOp::CreateProgram, program);
+	return program;
+}
+
+void APIENTRY captureAttachShader(GLuint program, GLuint shader) {
+	record(CaptureOp::AttachShader, program, shader);
+	realAttachShader(program, shader);
+}
+
+void APIENTRY captureDetachShader(GLuint program, GLuint shader) {
+	record(CaptureOp::DetachShader, program, shader);
+	realDetachShader(program, shader);
+}
+
+void APIENTRY captureLinkProgram(GLuint program) {
+	record(CaptureOp::LinkProgram, program);
+	realLinkProgram(program);
+}
+
+void APIENTRY captureDeleteProgram(GLuint program) {
+	record(CaptureOp::DeleteProgram, program);
+	realDeleteProgram(program);
+}
+
+void APIENTRY captureUseProgram(GLuint program) {
+	record(CaptureOp::UseProgram, program);
+	realUseProgram(program);
+}
+
+// Locations may differ between drivers, so the replayer looks the name up
+// again and maps the recorded location to its own.
+GLint APIENTRY captureGetUniformLocation(GLuint program, const GLchar* name) {
+	GLint location = realGetUniformLocation(program, name);
+	record(CaptureOp::GetUniformLocation, program, location);
+	putBlob(name, std::strlen(name));
+	return location;
+}
+
+void APIENTRY captureUniform1i(GLint location, GLint v0) {
+	record(CaptureOp::Uniform1i, location, v0);
+	realUniform1i(location, v0);
+}
+
+void APIENTRY captureUniform1f(GLint location, GLfloat v0) {
+	record(CaptureOp::Uniform1f, location, v0);
+	realUniform1f(location, v0);
+}
+
+void APIENTRY captureUniform2f(GLint location, GLfloat v0, GLfloat v1) {
+	record(CaptureOp::Uniform2f, location, v0, v1);
+	realUniform2f(location, v0, v1);
+}
+
+void APIENTRY captureUniform3f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2) {
+	record(CaptureOp::Uniform3f, location, v0, v1, v2);
+	realUniform3f(location, v0, v1, v2);
+}
+
+void APIENTRY captureUniform4f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3) {
+	record(CaptureOp::Uniform4f, location, v0, v1, v2, v3);
+	realUniform4f(location, v0, v1, v2, v3);
+}
+
+void APIENTRY captureUniform1iv(GLint location, GLsizei count, const GLint* value) {
+	record(CaptureOp::Uniform1iv, location, count);
+	putBlob(value, count * sizeof(GLint));
+	realUniform1iv(location, count, value);
+}
+
+void APIENTRY captureUniform1fv(GLint location, GLsizei count, const GLfloat* value) {
+	record(CaptureOp::Uniform1fv, location, count);
+	putBlob(value, count * sizeof(GLfloat));
+	realUniform1fv(location, count, value);
+}
+
+void APIENTRY captureUniform2fv(GLint location, GLsizei count, const GLfloat* value) {
+	record(CaptureOp::Uniform2fv, location, count);
+	putBlob(value, 2 * count * sizeof(GLfloat));
+	realUniform2fv(location, count, value);
+}
+
+void APIENTRY captureUniform3fv(GLint location, GLsizei count, const GLfloat* value) {
+	record(CaptureOp::Uniform3fv, location, count);
+	putBlob(value, 3 * count * sizeof(GLfloat));
+	realUniform3fv(location, count, value);
+}
+
+void APIENTRY captureUniform4fv(GLint location, GLsizei count, const GLfloat* value) {
+	record(CaptureOp::Uniform4fv, location, count);
+	putBlob(value, 4 * count * sizeof(GLfloat));
+	realUniform4fv(location, count, value);
+}
+
+void APIENTRY captureUniformMatrix3fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value) {
+	record(CaptureOp::UniformMatrix3fv, location, count, transpose);
+	putBlob(value, 9 * count * sizeof(GLfloat));
+	realUniformMatrix3fv(location, count, transpose, value);
+}
+
+void APIENTRY captureUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value) {
+	record(CaptureOp::UniformMatrix4fv, location, count, transpose);
+	putBlob(value, 16 * count * sizeof(GLfloat));
+	realUniformMatrix4fv(location, count, transpose, value);
+}
+
+void APIENTRY captureDrawArrays(GLenum mode, GLint first, GLsizei count) {
+	record(CaptureOp::DrawArrays, mode, first, count);
+	realDrawArrays(mode, first, count);
+}
+
+void APIENTRY captureDrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices) {
+	record(CaptureOp::DrawElements, mode, count, type, offset(indices));
+	realDrawElements(mode, count, type, indices);
+}
+
+void APIENTRY captureDrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances) {
+	record(CaptureOp::DrawArraysInstanced, mode, first, count, instances);
+	realDrawArraysInstanced(mode, first, count, instances);
+}
+
+void APIENTRY captureDrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instances) {
+	record(CaptureOp::DrawElementsInstanced, mode, count, type, offset(indices), instances);
+	realDrawElementsInstanced(mode, count, type, indices, instances);
+}
+
+void APIENTRY captureDrawElementsBaseVertex(GLenum mode, GLsizei count, GLenum type, const void* indices, GLint baseVertex) {
+	record(CaptureOp::DrawElementsBaseVertex, mode, count, type, offset(indices), baseVertex);
+	realDrawElementsBaseVertex(mode, count, type, indices, baseVertex);
+}
+
+// The per-draw index offsets are buffer offsets like the single draws', stored
+// widened to uint64.
+void APIENTRY captureMultiDrawElementsBaseVertex(GLenum mode, const GLsizei* count, GLenum type,
+	const void* const* indices, GLsizei drawcount, const GLint* baseVertex) {
+	std::vector<uint64_t> offsets(drawcount);
+	for (GLsizei i = 0; i < drawcount; i++) {
+		offsets[i] = offset(indices[i]);
+	}
+	record(CaptureOp::MultiDrawElementsBaseVertex, mode, type, drawcount);
+	putBlob(count, drawcount * sizeof(GLsizei));
+	putBlob(offsets.data(), drawcount * sizeof(uint64_t));
+	putBlob(baseVertex, drawcount * sizeof(GLint));
+	realMultiDrawElementsBaseVertex(mode, count, type, indices, drawcount, baseVertex);
+}
+
+void APIENTRY captureGenFramebuffers(GLsizei n, GLuint* framebuffers) {
+	realGenFramebuffers(n, framebuffers);
+	record(CaptureOp::GenFramebuffers, n);
+	putBlob(framebuffers, n * sizeof(GLuint));
+}
+
+void APIENTRY captureDeleteFramebuffers(GLsizei n, const GLuint* framebuffers) {
+	record(CaptureOp::DeleteFramebuffers, n);
+	putBlob(framebuffers, n * sizeof(GLuint));
+	realDeleteFramebuffers(n, framebuffers);
+}
+
+void APIENTRY captureBindFramebuffer(GLenum target, GLuint framebuffer) {
+	record(CaptureOp::BindFramebuffer, target, framebuffer);
+	realBindFramebuffer(target, framebuffer);
+}
+
+void APIENTRY captureFramebufferTexture2D(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level) {
+	record(CaptureOp::FramebufferTexture2D, target, attachment, textarget, texture, level);
+	realFramebufferTexture2D(target, attachment, textarget, texture, level);
+}
+
+void APIENTRY captureFramebufferRenderbuffer(GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer) {
+	record(CaptureOp::FramebufferRenderbuffer, target, attachment, renderbuffertarget, renderbuffer);
+	realFramebufferRenderbuffer(target, attachment, renderbuffertarget, renderbuffer);
+}
+
+void APIENTRY captureGenRenderbuffers(GLsizei n, GLuint* renderbuffers) {
+	realGenRenderbuffers(n, renderbuffers);
+	record(CaptureOp::GenRenderbuffers, n);
+	putBlob(renderbuffers, n * sizeof(GLuint));
+}
+
+void APIENTRY captureDeleteRenderbuffers(GLsizei n, const GLuint* renderbuffers) {
+	record(CaptureOp::DeleteRenderbuffers, n);
+	putBlob(renderbuffers, n * sizeof(GLuint));
+	realDeleteRenderbuffers(n, renderbuffers);
+}
+
+void APIENTRY captureBindRenderbuffer(GLenum target, GLuint renderbuffer) {
+	record(CaptureOp::BindRenderbuffer, target, renderbuffer);
+	realBindRenderbuffer(target, renderbuffer);
+}
+
+void APIENTRY captureRenderbufferStorage(GLenum target, GLenum internalformat, GLsizei width, GLsizei height) {
+	record(CaptureOp::RenderbufferStorage, target, internalformat, width, height);
+	realRenderbufferStorage(target, internalformat, width, height);
+}
+
+void APIENTRY captureBlitFramebuffer(GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1,
+	GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1, GLbitfield mask, GLenum filter) {
+	record(CaptureOp::BlitFramebuffer, srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1, mask, filter);
+	realBlitFramebuffer(srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1, mask, filter);
+}
+
+bool beginCapture(const char* path, int frames) {
+	if (capturing()) {
+		return false;
+	}
+
+	captureFile.open(path, std::ios::binary);
+	if (!captureFile) {
+		std::cout << "Failed to write capture, " << path << std::endl;
+		return false;
+	}
+
+	put(CAPTURE_MAGIC);
+	put(CAPTURE_VERSION);
+	framesLeft = frames;
+	disableExtensions();
+
+	// Start from the viewport the window already set up.
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	record(CaptureOp::Viewport, viewport[0], viewport[1], viewport[2], viewport[3]);
+
+#define INSTALL(name) real##name = glad_gl##name; glad_gl##name = capture##name;
+	CAPTURED_CALLS(INSTALL)
+#undef INSTALL
+
+	std::cout << "Capture, " << path << "\t" << frames << " frames" << std::endl;
+	return true;
+}
+
+void captureFrame() {
+	if (!capturing()) {
+		return;
+	}
+
+	record(CaptureOp::Frame);
+	if (--framesLeft <= 0) {
+		endCapture();
+	}
+}
+
+void endCapture() {
+	if (!capturing()) {
+		return;
+	}
+
+#define RESTORE(name) glad_gl##name = real##name;
+	CAPTURED_CALLS(RESTORE)
+#undef RESTORE
+
+	captureFile.close();
+	mappings.clear();
+	std::cout << "Capture finished" << std::endl;
+}
+
+bool capturing() {
+	return captureFile.is_open();
+}
@@ -0,0 +1,15 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+// Records GL calls and the data they read into a file the replay tool can
+// re-issue without the app or its assets. Calls are intercepted by swapping
+// glad's function pointers, so only calls made through glad are seen, and
+// extensions are switched off for the duration. Start the capture before
+// any GL objects are created so the file holds everything the frames use.
+bool beginCapture(const char* path, int frames);
+// Marks the end of a frame; the capture stops by itself after its frames.
+void captureFrame();
+void endCapture();
+bool capturing();
+
+#endif // !CAPTURE_H
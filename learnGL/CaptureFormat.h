@@ -0,0 +1,151 @@
+#ifndef CAPTURE_FORMAT_H
+#define CAPTURE_FORMAT_H
+
+#include <glad/glad.h>
+
+#include <cstdint>
+
+// A capture file starts with CAPTURE_MAGIC and CAPTURE_VERSION, followed by
+// one record per GL call: the CaptureOp, then its arguments in call order as
+// raw little-endian values. Object names are the ones the app saw, and
+// calls that create objects also record the names they got back. Data the
+// call reads from memory is stored as a uint64 byte count and the bytes.
+const uint32_t CAPTURE_MAGIC = 0x43474C4C; // "LLGC"
+const uint32_t CAPTURE_VERSION = 2;
+
+enum class CaptureOp : uint16_t {
+	// End of a frame; the replayer swaps here.
+	Frame,
+
+	Clear,
+	ClearColor,
+	Viewport,
+	Enable,
+	Disable,
+	BlendFunc,
+	DepthFunc,
+	PixelStorei,
+
+	ActiveTexture,
+	GenTextures,
+	DeleteTextures,
+	BindTexture,
+	TexParameteri,
+	TexImage2D,
+	TexSubImage2D,
+	GenerateMipmap,
+
+	GenBuffers,
+	DeleteBuffers,
+	BindBuffer,
+	BufferData,
+	BufferSubData,
+	BindBufferRange,
+	BindBufferBase,
+
+	GenVertexArrays,
+	DeleteVertexArrays,
+	BindVertexArray,
+	VertexAttribPointer,
+	VertexAttribIPointer,
+	EnableVertexAttribArray,
+	DisableVertexAttribArray,
+	VertexAttribDivisor,
+
+	CreateShader,
+	ShaderSource,
+	CompileShader,
+	DeleteShader,
+	CreateProgram,
+	AttachShader,
+	DetachShader,
+	LinkProgram,
+	DeleteProgram,
+	UseProgram,
+	GetUniformLocation,
+	Uniform1i,
+	Uniform1f,
+	Uniform2f,
+	Uniform3f,
+	Uniform4f,
+	Uniform1iv,
+	Uniform1fv,
+	Uniform2fv,
+	Uniform3fv,
+	Uniform4fv,
+	UniformMatrix3fv,
+	UniformMatrix4fv,
+
+	DrawArrays,
+	DrawElements,
+	DrawArraysInstanced,
+	DrawElementsInstanced,
+	DrawElementsBaseVertex,
+	MultiDrawElementsBaseVertex,
+
+	GenFramebuffers,
+	DeleteFramebuffers,
+	BindFramebuffer,
+	FramebufferTexture2D,
+	FramebufferRenderbuffer,
+	GenRenderbuffers,
+	DeleteRenderbuffers,
+	BindRenderbuffer,
+	RenderbufferStorage,
+	BlitFramebuffer,
+};
+
+// Size of the client memory a TexImage/TexSubImage call reads, with
+// GL_UNPACK_ALIGNMENT at alignment. The replayer checks blobs against it.
+inline uint64_t imageSize(GLsizei width, GLsizei height, GLenum format, GLenum type, GLint alignment) {
+	uint64_t components = 4;
+	switch (format)
+	{
+	case GL_RED:
+	case GL_RED_INTEGER:
+	case GL_DEPTH_COMPONENT:
+		components = 1;
+		break;
+	case GL_RG:
+	case GL_RG_INTEGER:
+		components = 2;
+		break;
+	case GL_RGB:
+	case GL_BGR:
+	case GL_RGB_INTEGER:
+		components = 3;
+		break;
+	default:
+		break;
+	}
+
+	uint64_t bytes = 1;
+	switch (type)
+	{
+	case GL_UNSIGNED_SHORT:
+	case GL_SHORT:
+	case GL_HALF_FLOAT:
+		bytes = 2;
+		break;
+	case GL_UNSIGNED_INT:
+	case GL_INT:
+	case GL_FLOAT:
+		bytes = 4;
+		break;
+	case GL_UNSIGNED_INT_24_8:
+	case GL_UNSIGNED_INT_8_8_8_8:
+	case GL_UNSIGNED_INT_8_8_8_8_REV:
+	case GL_UNSIGNED_INT_2_10_10_10_REV:
+		components = 1;
+		bytes = 4;
+		break;
+	default:
+		break;
+	}
+
+	uint64_t pixel = components * bytes;
+	uint64_t row = (width * pixel + alignment - 1) / alignment * alignment;
+	return height > 0 ? row * (height - 1) + width * pixel : 0;
+}
+
+#endif // !CAPTURE_FORMAT_H
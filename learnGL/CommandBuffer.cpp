@@ -0,0 +1,183 @@
+#include "CommandBuffer.h"
+#include "Extensions.h"
+
+#include <algorithm>
+#include <cstring>
+
+const GLuint MAX_TEXTURE_UNITS = 16;
+const GLuint UNKNOWN = GLuint(-1);
+
+template <typename T>
+void CommandBuffer::write(const T& value)
+{
+	auto bytes = reinterpret_cast<const unsigned char*>(&value);
+	data.insert(data.end(), bytes, bytes + sizeof(T));
+}
+
+template <typename T>
+T read(const unsigned char*& cursor) {
+	T value;
+	std::memcpy(&value, cursor, sizeof(T));
+	cursor += sizeof(T);
+	return value;
+}
+
+void CommandBuffer::bindShader(const Shader& shader)
+{
+	write(shader.separable ? Command::BindPipeline : Command::BindProgram);
+	write(GLuint(shader.ID));
+	write(Command::FlushShader);
+	write(&shader);
+}
+
+void CommandBuffer::bindProgram(GLuint program)
+{
+	write(Command::BindProgram);
+	write(program);
+}
+
+void CommandBuffer::bindVertexArray(GLuint vao)
+{
+	write(Command::BindVertexArray);
+	write(vao);
+}
+
+void CommandBuffer::bindTextures(GLuint first, const GLuint* textures, GLuint count)
+{
+	if (first + count > MAX_TEXTURE_UNITS) {
+		count = first < MAX_TEXTURE_UNITS ? MAX_TEXTURE_UNITS - first : 0;
+	}
+
+	write(Command::BindTextures);
+	write(first);
+	write(count);
+	for (GLuint i = 0; i < count; i++) {
+		write(textures[i]);
+	}
+}
+
+void CommandBuffer::bindUniformRange(GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+{
+	write(Command::BindUniformRange);
+	write(index);
+	write(buffer);
+	write(offset);
+	write(size);
+}
+
+void CommandBuffer::drawElements(GLenum mode, GLsizei count, GLenum type, size_t offset)
+{
+	write(Command::DrawElements);
+	write(mode);
+	write(count);
+	write(type);
+	write(offset);
+}
+
+void CommandBuffer::append(const CommandBuffer& other)
+{
+	data.insert(data.end(), other.data.begin(), other.data.end());
+}
+
+void CommandBuffer::clear()
+{
+	data.clear();
+}
+
+size_t CommandBuffer::size() const
+{
+	return data.size();
+}
+
+void CommandBuffer::execute() const
+{
+	execute({ this });
+}
+
+// Bindings already made during this replay are skipped, which matters once
+// many recorded draws share state.
+void CommandBuffer::execute(const std::vector<const CommandBuffer*>& buffers)
+{
+	GLuint program = UNKNOWN, pipeline = UNKNOWN, vao = UNKNOWN;
+	GLuint textures[MAX_TEXTURE_UNITS];
+	std::fill(textures, textures + MAX_TEXTURE_UNITS, UNKNOWN);
+	GLuint activeUnit = 0;
+	glActiveTexture(GL_TEXTURE0);
+
+	for (auto buffer : buffers) {
+		const unsigned char* cursor = buffer->data.data();
+		const unsigned char* end = cursor + buffer->data.size();
+
+		while (cursor < end) {
+			switch (read<Command>(cursor))
+			{
+			case Command::BindProgram: {
+				auto id = read<GLuint>(cursor);
+				if (id != program) {
+					glUseProgram(id);
+					program = id;
+					pipeline = UNKNOWN;
+				}
+				break;
+			}
+			case Command::BindPipeline: {
+				auto id = read<GLuint>(cursor);
+				if (id != pipeline || program != 0) {
+					glUseProgram(0);
+					glExtensions().bindProgramPipeline(id);
+					pipeline = id;
+					program = 0;
+				}
+				break;
+			}
+			case Command::FlushShader:
+				// Only dirty uniforms are uploaded, so this is cheap when
+				// nothing changed since the last replay.
+				read<const Shader*>(cursor)->flush();
+				break;
+			case Command::BindVertexArray: {
+				auto id = read<GLuint>(cursor);
+				if (id != vao) {
+					glBindVertexArray(id);
+					vao = id;
+				}
+				break;
+			}
+			case Command::BindTextures: {
+				auto first = read<GLuint>(cursor);
+				auto count = read<GLuint>(cursor);
+				for (GLuint unit = first; unit < first + count; unit++) {
+					auto id = read<GLuint>(cursor);
+					if (textures[unit] != id) {
+						if (activeUnit != unit) {
+							glActiveTexture(GL_TEXTURE0 + unit);
+							activeUnit = unit;
+						}
+						glBindTexture(GL_TEXTURE_2D, id);
+						textures[unit] = id;
+					}
+				}
+				break;
+			}
+			case Command::BindUniformRange: {
+				auto index = read<GLuint>(cursor);
+				auto id = read<GLuint>(cursor);
+				auto offset = read<GLintptr>(cursor);
+				auto size = read<GLsizeiptr>(cursor);
+				glBindBufferRange(GL_UNIFORM_BUFFER, index, id, offset, size);
+				break;
+			}
+			case Command::DrawElements: {
+				auto mode = read<GLenum>(cursor);
+				auto count = read<GLsizei>(cursor);
+				auto type = read<GLenum>(cursor);
+				auto offset = read<size_t>(cursor);
+				glDrawElements(mode, count, type, (void*)offset);
+				break;
+			}
+			default:
+				return;
+			}
+		}
+	}
+}
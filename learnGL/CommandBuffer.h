@@ -0,0 +1,50 @@
+#ifndef COMMAND_BUFFER_H
+#define COMMAND_BUFFER_H
+
+#include <glad/glad.h>
+#include "shader.h"
+
+#include <cstdint>
+#include <vector>
+
+enum class Command : uint8_t {
+	BindProgram,
+	BindPipeline,
+	FlushShader,
+	BindVertexArray,
+	BindTextures,
+	BindUniformRange,
+	DrawElements,
+};
+
+// Records draw state as a packed byte stream: a Command byte followed by its
+// arguments. Recording makes no GL calls, so any thread can fill its own
+// buffer without locks; only execute() needs the GL thread. Buffers from
+// several threads are replayed back to back in the order given.
+class CommandBuffer {
+public:
+	// Also uploads, at execute(), any uniforms set since the shader's last
+	// use() or flush(), so the shader must outlive the recording.
+	void bindShader(const Shader& shader);
+	void bindProgram(GLuint program);
+	void bindVertexArray(GLuint vao);
+	// Binds count 2D textures to units first .. first + count - 1.
+	void bindTextures(GLuint first, const GLuint* textures, GLuint count);
+	void bindUniformRange(GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+	void drawElements(GLenum mode, GLsizei count, GLenum type, size_t offset);
+
+	void append(const CommandBuffer& other);
+	void clear();
+	size_t size() const;
+
+	void execute() const;
+	static void execute(const std::vector<const CommandBuffer*>& buffers);
+
+private:
+	std::vector<unsigned char> data;
+
+	template <typename T>
+	void write(const T& value);
+};
+
+#endif // !COMMAND_BUFFER_H
@@ -0,0 +1,82 @@
+#include "DynamicResolution.h"
+
+#include <cmath>
+
+DynamicResolution::DynamicResolution(double targetMs, float minScale, float maxScale, int settleFrames)
+	: target(), output(0), viewport(), targetMs(targetMs), minScale(minScale), maxScale(maxScale),
+	current(maxScale), settleFrames(settleFrames), settle(0)
+{
+}
+
+DynamicResolution::~DynamicResolution()
+{
+	pool.release(target);
+}
+
+void DynamicResolution::begin()
+{
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &output);
+	glGetIntegerv(GL_VIEWPORT, viewport);
+
+	int width = int(viewport[2] * current);
+	int height = int(viewport[3] * current);
+	width = width > 0 ? width : 1;
+	height = height > 0 ? height : 1;
+
+	// Scaling down stays within the allocation, so only growing past it
+	// ever creates a new target.
+	if (!target.framebuffer) {
+		target = pool.acquire(width, height);
+	}
+	else {
+		pool.resize(target, width, height);
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, target.framebuffer);
+	glViewport(0, 0, width, height);
+}
+
+void DynamicResolution::end()
+{
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, target.framebuffer);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, output);
+	glBlitFramebuffer(0, 0, target.width, target.height,
+		viewport[0], viewport[1], viewport[0] + viewport[2], viewport[1] + viewport[3],
+		GL_COLOR_BUFFER_BIT, GL_LINEAR);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, output);
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
+
+void DynamicResolution::update(double gpuMs)
+{
+	if (gpuMs <= 0) {
+		return;
+	}
+	if (settle > 0) {
+		settle--;
+		return;
+	}
+
+	// Aim for about 10% under the target and don't chase small swings.
+	double ratio = targetMs / gpuMs;
+	if (ratio >= 1.0 && ratio <= 1.2) {
+		return;
+	}
+
+	// GPU time goes roughly with pixel count, so each side scales with the
+	// square root. Steps of 1/32 keep the number of distinct sizes small.
+	float next = float(current * std::sqrt(ratio / 1.1));
+	next = std::round(next * 32) / 32;
+	next = next < minScale ? minScale : next > maxScale ? maxScale : next;
+
+	if (next != current) {
+		current = next;
+		settle = settleFrames;
+	}
+}
+
+float DynamicResolution::scale() const
+{
+	return current;
+}
@@ -0,0 +1,38 @@
+#ifndef DYNAMIC_RESOLUTION_H
+#define DYNAMIC_RESOLUTION_H
+
+#include <glad/glad.h>
+#include "RenderTarget.h"
+
+// Renders the scene offscreen at a fraction of the viewport and upscales it
+// into whatever framebuffer was bound, picking the fraction from measured
+// GPU frame time so a heavy scene holds its target by dropping resolution.
+class DynamicResolution {
+public:
+	// settleFrames should cover the window the frame times are averaged
+	// over, so a change is judged only on samples taken after it.
+	DynamicResolution(double targetMs, float minScale = 0.5f, float maxScale = 1.0f, int settleFrames = 60);
+	~DynamicResolution();
+
+	// Redirects drawing into the scaled target.
+	void begin();
+	// Upscales into the framebuffer and viewport that were current at begin().
+	void end();
+	// Feeds the controller the latest GPU time of what begin()/end() wrap.
+	void update(double gpuMs);
+	float scale() const;
+
+private:
+	RenderTargetPool pool;
+	RenderTarget target;
+	GLint output;
+	GLint viewport[4];
+	double targetMs;
+	float minScale;
+	float maxScale;
+	float current;
+	int settleFrames;
+	int settle;
+};
+
+#endif // !DYNAMIC_RESOLUTION_H
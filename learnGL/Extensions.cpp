@@ -0,0 +1,49 @@
+#include "Extensions.h"
+
+#include <GLFW/glfw3.h>
+
+template <typename T>
+bool loadProc(T& proc, const char* name) {
+	proc = reinterpret_cast<T>(glfwGetProcAddress(name));
+	return proc != NULL;
+}
+
+Extensions loadExtensions() {
+	Extensions ext = {};
+
+	if (glfwExtensionSupported("GL_ARB_separate_shader_objects")) {
+		ext.separateShaderObjects =
+			loadProc(ext.programParameteri, "glProgramParameteri") &&
+			loadProc(ext.genProgramPipelines, "glGenProgramPipelines") &&
+			loadProc(ext.deleteProgramPipelines, "glDeleteProgramPipelines") &&
+			loadProc(ext.bindProgramPipeline, "glBindProgramPipeline") &&
+			loadProc(ext.useProgramStages, "glUseProgramStages") &&
+			loadProc(ext.activeShaderProgram, "glActiveShaderProgram");
+	}
+
+	if (glfwExtensionSupported("GL_ARB_buffer_storage")) {
+		ext.immutableBuffers = loadProc(ext.bufferStorage, "glBufferStorage");
+	}
+
+	if (glfwExtensionSupported("GL_ARB_multi_draw_indirect")) {
+		ext.multiDrawIndirect = loadProc(ext.multiDrawElementsIndirect, "glMultiDrawElementsIndirect");
+	}
+
+	return ext;
+}
+
+Extensions extensions;
+bool extensionsLoaded = false;
+
+const Extensions& glExtensions() {
+	if (!extensionsLoaded) {
+		extensions = loadExtensions();
+		extensionsLoaded = true;
+	}
+	return extensions;
+}
+
+void disableExtensions() {
+	extensions = Extensions();
+	extensionsLoaded = true;
+}
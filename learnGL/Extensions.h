@@ -0,0 +1,57 @@
+#ifndef EXTENSIONS_H
+#define EXTENSIONS_H
+
+#include <glad/glad.h>
+
+// glad is generated for plain GL 3.3 core, so anything newer is loaded here
+// by hand once a context is current. Missing entry points stay NULL.
+
+#ifndef GL_PROGRAM_SEPARABLE
+#define GL_PROGRAM_SEPARABLE 0x8258
+#endif
+#ifndef GL_VERTEX_SHADER_BIT
+#define GL_VERTEX_SHADER_BIT 0x00000001
+#endif
+#ifndef GL_FRAGMENT_SHADER_BIT
+#define GL_FRAGMENT_SHADER_BIT 0x00000002
+#endif
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+#ifndef GL_DYNAMIC_STORAGE_BIT
+#define GL_DYNAMIC_STORAGE_BIT 0x0100
+#endif
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+
+struct Extensions {
+	// GL_ARB_separate_shader_objects
+	bool separateShaderObjects;
+	void (APIENTRY* programParameteri)(GLuint program, GLenum pname, GLint value);
+	void (APIENTRY* genProgramPipelines)(GLsizei n, GLuint* pipelines);
+	void (APIENTRY* deleteProgramPipelines)(GLsizei n, const GLuint* pipelines);
+	void (APIENTRY* bindProgramPipeline)(GLuint pipeline);
+	void (APIENTRY* useProgramStages)(GLuint pipeline, GLbitfield stages, GLuint program);
+	void (APIENTRY* activeShaderProgram)(GLuint pipeline, GLuint program);
+
+	// GL_ARB_buffer_storage
+	bool immutableBuffers;
+	void (APIENTRY* bufferStorage)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
+	// GL_ARB_multi_draw_indirect, core in 4.3
+	bool multiDrawIndirect;
+	void (APIENTRY* multiDrawElementsIndirect)(GLenum mode, GLenum type, const void* indirect, GLsizei drawcount, GLsizei stride);
+};
+
+// Needs a current context; loads on first call.
+const Extensions& glExtensions();
+
+// Reports every extension as missing from now on, forcing the core paths,
+// e.g. while capturing GL calls.
+void disableExtensions();
+
+#endif // !EXTENSIONS_H
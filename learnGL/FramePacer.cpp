@@ -0,0 +1,97 @@
+#include "FramePacer.h"
+
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <thread>
+
+void setVSync(VSync mode) {
+	int interval = int(mode);
+
+	if (mode == VSync::Adaptive &&
+		!glfwExtensionSupported("WGL_EXT_swap_control_tear") &&
+		!glfwExtensionSupported("GLX_EXT_swap_control_tear")) {
+		std::cout << "Adaptive vsync unsupported, using vsync" << std::endl;
+		interval = 1;
+	}
+
+	glfwSwapInterval(interval);
+}
+
+FramePacer::FramePacer(double targetFps, int window)
+	: targetFps(targetFps), spinMargin(std::chrono::milliseconds(1)),
+	samples(window > 0 ? window : 1, 0.0), cursor(0), started(false)
+{
+}
+
+void FramePacer::wait()
+{
+	using namespace std::chrono;
+
+	if (targetFps > 0 && started) {
+		auto now = steady_clock::now();
+		auto sleepUntil = deadline - spinMargin;
+
+		if (now < sleepUntil) {
+			std::this_thread::sleep_until(sleepUntil);
+			// Grows at once to cover a late wakeup, then eases back toward
+			// 1ms as an average over the last 16 or so frames, so a single
+			// descheduling doesn't turn every later frame into a busy wait.
+			auto overshoot = std::min<steady_clock::duration>(steady_clock::now() - sleepUntil, milliseconds(4));
+			if (overshoot > spinMargin) {
+				spinMargin = overshoot;
+			}
+			else {
+				auto floor = std::max<steady_clock::duration>(overshoot, milliseconds(1));
+				spinMargin -= (spinMargin - floor) / 16;
+			}
+		}
+
+		while (steady_clock::now() < deadline) {
+			std::this_thread::yield();
+		}
+	}
+
+	auto now = steady_clock::now();
+	if (started) {
+		samples[cursor % samples.size()] = duration<double, std::milli>(now - last).count();
+		cursor++;
+	}
+	last = now;
+	started = true;
+
+	if (targetFps > 0) {
+		auto period = duration_cast<steady_clock::duration>(duration<double>(1.0 / targetFps));
+		deadline += period;
+		// After a long stall start over rather than rushing frames out.
+		if (deadline < now) {
+			deadline = now + period;
+		}
+	}
+}
+
+FrameStats FramePacer::stats() const
+{
+	FrameStats s = { 0, 0, 0, 0, 0 };
+	s.frames = int(std::min(cursor, samples.size()));
+	if (s.frames == 0) {
+		return s;
+	}
+
+	s.minMs = s.maxMs = samples[0];
+	for (int i = 0; i < s.frames; i++) {
+		s.meanMs += samples[i];
+		s.minMs = std::min(s.minMs, samples[i]);
+		s.maxMs = std::max(s.maxMs, samples[i]);
+	}
+	s.meanMs /= s.frames;
+
+	for (int i = 0; i < s.frames; i++) {
+		s.stdDevMs += (samples[i] - s.meanMs) * (samples[i] - s.meanMs);
+	}
+	s.stdDevMs = std::sqrt(s.stdDevMs / s.frames);
+
+	return s;
+}
@@ -0,0 +1,48 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#include <chrono>
+#include <vector>
+
+enum class VSync {
+	Off = 0,
+	On = 1,
+	// Tears instead of waiting a whole extra interval when a frame is late.
+	// Falls back to On where the swap_control_tear extension is missing.
+	Adaptive = -1,
+};
+
+// Needs a current context.
+void setVSync(VSync mode);
+
+// Frame times over the pacer's recent window, in milliseconds.
+struct FrameStats {
+	int frames;
+	double meanMs;
+	double stdDevMs;
+	double minMs;
+	double maxMs;
+};
+
+// Caps the frame rate by sleeping for most of the remaining frame and
+// spinning the rest on the monotonic clock. The spin margin jumps to any
+// larger sleep overshoot, so coarse OS timers still hit the deadline, and
+// decays back once wakeups are punctual again.
+class FramePacer {
+public:
+	// 0 leaves the rate uncapped and only collects stats.
+	FramePacer(double targetFps = 0, int window = 240);
+	double targetFps;
+	// Call once per frame, after the swap.
+	void wait();
+	FrameStats stats() const;
+private:
+	std::chrono::steady_clock::time_point deadline;
+	std::chrono::steady_clock::time_point last;
+	std::chrono::steady_clock::duration spinMargin;
+	std::vector<double> samples;
+	size_t cursor;
+	bool started;
+};
+
+#endif // !FRAME_PACER_H
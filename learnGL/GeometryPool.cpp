@@ -0,0 +1,181 @@
+#include "GeometryPool.h"
+#include "Extensions.h"
+
+#include <iostream>
+
+GeometryPoolBase::GeometryPoolBase(GpuHeap& heap, size_t vertexSize, size_t maxVertices, size_t maxIndices)
+	: heap(heap),
+	vertexRange(heap.allocate(vertexSize * maxVertices, vertexSize)),
+	indexRange(heap.allocate(sizeof(uint32_t) * maxIndices, sizeof(uint32_t))),
+	poolArray(0),
+	vertexSize(vertexSize),
+	vertexSpace(maxVertices),
+	indexSpace(maxIndices)
+{
+	// The element buffer binding is VAO state, so it only needs doing once.
+	glGenVertexArrays(1, &poolArray);
+	glBindVertexArray(poolArray);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexRange.buffer);
+	glBindVertexArray(0);
+}
+
+GeometryPoolBase::~GeometryPoolBase()
+{
+	for (auto& r : retired) {
+		glDeleteSync(r.fence);
+	}
+	glDeleteVertexArrays(1, &poolArray);
+	heap.free(vertexRange);
+	heap.free(indexRange);
+}
+
+bool GeometryPoolBase::add(const void* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount, PooledMesh& mesh)
+{
+	size_t firstVertex, firstIndex;
+	if (!vertexSpace.allocate(vertexCount, 1, firstVertex)) {
+		std::cout << "Geometry Pool, out of vertices for " << vertexCount << std::endl;
+		return false;
+	}
+	if (!indexSpace.allocate(indexCount, 1, firstIndex)) {
+		std::cout << "Geometry Pool, out of indices for " << indexCount << std::endl;
+		vertexSpace.free(firstVertex);
+		return false;
+	}
+
+	heap.write(vertexRange, vertices, vertexCount * vertexSize, firstVertex * vertexSize);
+	heap.write(indexRange, indices, indexCount * sizeof(uint32_t), firstIndex * sizeof(uint32_t));
+
+	mesh = PooledMesh{ GLsizei(indexCount), GLuint(firstIndex), GLint(firstVertex) };
+	return true;
+}
+
+void GeometryPoolBase::remove(const PooledMesh& mesh)
+{
+	removed.push_back(mesh);
+}
+
+void GeometryPoolBase::retire()
+{
+	if (!removed.empty()) {
+		retired.push_back(Retired{ glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), removed });
+		removed.clear();
+	}
+
+	size_t done = 0;
+	for (auto& r : retired) {
+		GLenum status = glClientWaitSync(r.fence, 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+			break;
+		}
+		glDeleteSync(r.fence);
+		for (auto& mesh : r.meshes) {
+			vertexSpace.free(size_t(mesh.baseVertex));
+			indexSpace.free(mesh.firstIndex);
+		}
+		done++;
+	}
+	retired.erase(retired.begin(), retired.begin() + done);
+}
+
+void GeometryPoolBase::draw(const PooledMesh* meshes, size_t count, GLenum mode) const
+{
+	if (count == 0) {
+		return;
+	}
+
+	counts.resize(count);
+	offsets.resize(count);
+	baseVertices.resize(count);
+	for (size_t i = 0; i < count; i++) {
+		counts[i] = meshes[i].count;
+		offsets[i] = (void*)(indexRange.offset + meshes[i].firstIndex * sizeof(uint32_t));
+		baseVertices[i] = meshes[i].baseVertex;
+	}
+
+	glBindVertexArray(poolArray);
+	glMultiDrawElementsBaseVertex(mode, counts.data(), GL_UNSIGNED_INT, offsets.data(), GLsizei(count), baseVertices.data());
+}
+
+GLuint GeometryPoolBase::vertexArray() const
+{
+	return poolArray;
+}
+
+GLuint GeometryPoolBase::indexBase() const
+{
+	return GLuint(indexRange.offset / sizeof(uint32_t));
+}
+
+size_t GeometryPoolBase::verticesUsed() const
+{
+	return vertexSpace.used();
+}
+
+size_t GeometryPoolBase::indicesUsed() const
+{
+	return indexSpace.used();
+}
+
+GeometryDrawList::GeometryDrawList() : pool(NULL), commandBuffer(0), drawCount(0)
+{
+}
+
+GeometryDrawList::~GeometryDrawList()
+{
+	if (commandBuffer) {
+		glDeleteBuffers(1, &commandBuffer);
+	}
+}
+
+void GeometryDrawList::set(const GeometryPoolBase& pool, const PooledMesh* meshes, size_t count)
+{
+	this->pool = &pool;
+	drawCount = GLsizei(count);
+
+	if (glExtensions().multiDrawIndirect) {
+		std::vector<DrawCommand> commands(count);
+		for (size_t i = 0; i < count; i++) {
+			commands[i] = DrawCommand{ GLuint(meshes[i].count), 1, pool.indexBase() + meshes[i].firstIndex, meshes[i].baseVertex, 0 };
+		}
+
+		if (!commandBuffer) {
+			glGenBuffers(1, &commandBuffer);
+		}
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+		glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(DrawCommand), commands.data(), GL_STATIC_DRAW);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+		return;
+	}
+
+	GLuint indexBase = pool.indexBase();
+	counts.resize(count);
+	offsets.resize(count);
+	baseVertices.resize(count);
+	for (size_t i = 0; i < count; i++) {
+		counts[i] = meshes[i].count;
+		offsets[i] = (void*)((indexBase + size_t(meshes[i].firstIndex)) * sizeof(uint32_t));
+		baseVertices[i] = meshes[i].baseVertex;
+	}
+}
+
+void GeometryDrawList::draw(GLenum mode) const
+{
+	if (!pool || drawCount == 0) {
+		return;
+	}
+
+	glBindVertexArray(pool->vertexArray());
+	if (commandBuffer) {
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+		glExtensions().multiDrawElementsIndirect(mode, GL_UNSIGNED_INT, NULL, drawCount, 0);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	}
+	else {
+		glMultiDrawElementsBaseVertex(mode, counts.data(), GL_UNSIGNED_INT, offsets.data(), drawCount, baseVertices.data());
+	}
+}
+
+bool GeometryDrawList::indirect() const
+{
+	return commandBuffer != 0;
+}
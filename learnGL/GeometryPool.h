@@ -0,0 +1,121 @@
+#ifndef GEOMETRY_POOL_H
+#define GEOMETRY_POOL_H
+
+#include <glad/glad.h>
+#include "GpuHeap.h"
+#include "VertexLayout.h"
+
+#include <cstdint>
+#include <vector>
+
+// Where a mesh landed in its pool, in vertices and indices rather than bytes.
+struct PooledMesh {
+	GLsizei count;
+	GLuint firstIndex;
+	GLint baseVertex;
+};
+
+// Meshes sharing a vertex format packed into one vertex range and one index
+// range of a GpuHeap, behind a single VAO. Indices are mesh-local and the
+// base vertex moves them to the mesh's vertices, so any run of meshes draws
+// with one bind and one glMultiDrawElementsBaseVertex.
+//
+// The vertex format comes from GeometryPool<Vertex> below; this part holds
+// everything that doesn't depend on it.
+class GeometryPoolBase {
+public:
+	~GeometryPoolBase();
+
+	// Returns false when the pool is out of vertices or indices.
+	bool add(const void* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount, PooledMesh& mesh);
+	// Like GpuHeap::free, the space is reused only once retire() sees the GPU
+	// is past every frame that might still draw the mesh.
+	void remove(const PooledMesh& mesh);
+	// Once per frame.
+	void retire();
+
+	// Binds the VAO and draws meshes with one call.
+	void draw(const PooledMesh* meshes, size_t count, GLenum mode = GL_TRIANGLES) const;
+
+	GLuint vertexArray() const;
+	// Offset of the pool's first index in the element buffer, in indices.
+	GLuint indexBase() const;
+	size_t verticesUsed() const;
+	size_t indicesUsed() const;
+
+protected:
+	GeometryPoolBase(GpuHeap& heap, size_t vertexSize, size_t maxVertices, size_t maxIndices);
+
+	GpuHeap& heap;
+	GpuAllocation vertexRange;
+	GpuAllocation indexRange;
+	GLuint poolArray;
+
+private:
+	struct Retired {
+		GLsync fence;
+		std::vector<PooledMesh> meshes;
+	};
+
+	size_t vertexSize;
+	OffsetAllocator vertexSpace;
+	OffsetAllocator indexSpace;
+	std::vector<PooledMesh> removed;
+	std::vector<Retired> retired;
+	mutable std::vector<GLsizei> counts;
+	mutable std::vector<const void*> offsets;
+	mutable std::vector<GLint> baseVertices;
+};
+
+template <typename Vertex>
+class GeometryPool : public GeometryPoolBase {
+public:
+	GeometryPool(GpuHeap& heap, size_t maxVertices, size_t maxIndices)
+		: GeometryPoolBase(heap, sizeof(Vertex), maxVertices, maxIndices)
+	{
+		glBindVertexArray(poolArray);
+		glBindBuffer(GL_ARRAY_BUFFER, vertexRange.buffer);
+		setVertexLayout<Vertex>(vertexRange.offset);
+		glBindVertexArray(0);
+	}
+
+	bool add(const Vertex* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount, PooledMesh& mesh) {
+		return GeometryPoolBase::add(vertices, vertexCount, indices, indexCount, mesh);
+	}
+};
+
+// A fixed set of a pool's meshes, e.g. a whole scene layer, ready to draw
+// every frame without rebuilding anything. With GL 4.3 or
+// ARB_multi_draw_indirect the draw commands are written once into a buffer
+// and the layer is one glMultiDrawElementsIndirect; otherwise the arrays for
+// glMultiDrawElementsBaseVertex are kept instead.
+class GeometryDrawList {
+public:
+	GeometryDrawList();
+	~GeometryDrawList();
+
+	// The pool must outlive the list.
+	void set(const GeometryPoolBase& pool, const PooledMesh* meshes, size_t count);
+	void draw(GLenum mode = GL_TRIANGLES) const;
+
+	bool indirect() const;
+
+private:
+	// Layout fixed by GL.
+	struct DrawCommand {
+		GLuint count;
+		GLuint instanceCount;
+		GLuint firstIndex;
+		GLint baseVertex;
+		GLuint baseInstance;
+	};
+
+	const GeometryPoolBase* pool;
+	GLuint commandBuffer;
+	GLsizei drawCount;
+	std::vector<GLsizei> counts;
+	std::vector<const void*> offsets;
+	std::vector<GLint> baseVertices;
+};
+
+#endif // !GEOMETRY_POOL_H
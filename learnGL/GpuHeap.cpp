@@ -0,0 +1,223 @@
+#include "GpuHeap.h"
+#include "Extensions.h"
+
+#include <cstring>
+#include <iostream>
+
+OffsetAllocator::OffsetAllocator(size_t size) : total(size), inUse(0)
+{
+	insertFree(0, size);
+}
+
+bool OffsetAllocator::allocate(size_t size, size_t alignment, size_t& offset)
+{
+	// Smallest free range with room for the worst-case padding as well.
+	auto fit = freeBySize.lower_bound(size + alignment - 1);
+	if (fit == freeBySize.end() || size == 0) {
+		return false;
+	}
+
+	size_t start = fit->second;
+	size_t length = fit->first;
+	eraseFree(freeByOffset.find(start));
+
+	size_t aligned = (start + alignment - 1) / alignment * alignment;
+	size_t used = aligned - start + size;
+	if (length > used) {
+		insertFree(start + used, length - used);
+	}
+
+	allocations[aligned] = std::make_pair(start, used);
+	inUse += used;
+	offset = aligned;
+	return true;
+}
+
+void OffsetAllocator::free(size_t offset)
+{
+	auto found = allocations.find(offset);
+	if (found == allocations.end()) {
+		return;
+	}
+
+	size_t start = found->second.first;
+	size_t size = found->second.second;
+	allocations.erase(found);
+	inUse -= size;
+
+	// Merge with the free ranges on either side.
+	auto next = freeByOffset.lower_bound(start);
+	if (next != freeByOffset.end() && next->first == start + size) {
+		size += next->second;
+		eraseFree(next);
+	}
+	auto previous = freeByOffset.lower_bound(start);
+	if (previous != freeByOffset.begin()) {
+		--previous;
+		if (previous->first + previous->second == start) {
+			start = previous->first;
+			size += previous->second;
+			eraseFree(previous);
+		}
+	}
+
+	insertFree(start, size);
+}
+
+size_t OffsetAllocator::size() const
+{
+	return total;
+}
+
+size_t OffsetAllocator::used() const
+{
+	return inUse;
+}
+
+void OffsetAllocator::insertFree(size_t offset, size_t size)
+{
+	freeByOffset[offset] = size;
+	freeBySize.insert(std::make_pair(size, offset));
+}
+
+void OffsetAllocator::eraseFree(std::map<size_t, size_t>::iterator it)
+{
+	auto range = freeBySize.equal_range(it->second);
+	for (auto bySize = range.first; bySize != range.second; ++bySize) {
+		if (bySize->second == it->first) {
+			freeBySize.erase(bySize);
+			break;
+		}
+	}
+	freeByOffset.erase(it);
+}
+
+GpuHeap::GpuHeap(size_t arenaSize) : arenaSize(arenaSize), mapped(glExtensions().immutableBuffers)
+{
+}
+
+GpuHeap::~GpuHeap()
+{
+	for (auto& r : retired) {
+		glDeleteSync(r.fence);
+	}
+	for (auto& arena : arenaList) {
+		if (arena.data) {
+			glBindBuffer(GL_COPY_WRITE_BUFFER, arena.buffer);
+			glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+		}
+		glDeleteBuffers(1, &arena.buffer);
+	}
+}
+
+int GpuHeap::addArena(size_t size)
+{
+	Arena arena = { 0, NULL, OffsetAllocator(size) };
+	glGenBuffers(1, &arena.buffer);
+
+	// The copy target leaves whatever is bound for drawing alone.
+	glBindBuffer(GL_COPY_WRITE_BUFFER, arena.buffer);
+	if (mapped) {
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glExtensions().bufferStorage(GL_COPY_WRITE_BUFFER, size, NULL, flags | GL_DYNAMIC_STORAGE_BIT);
+		arena.data = static_cast<char*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, size, flags));
+	}
+	else {
+		glBufferData(GL_COPY_WRITE_BUFFER, size, NULL, GL_DYNAMIC_DRAW);
+	}
+
+	std::cout << "GPU Arena, " << size / 1024 << "KB" << (arena.data ? " persistent" : "") << std::endl;
+	arenaList.push_back(arena);
+	return int(arenaList.size() - 1);
+}
+
+GpuAllocation GpuHeap::allocate(size_t size, size_t alignment)
+{
+	// Nothing to place, and OffsetAllocator refuses empty ranges anyway.
+	if (size == 0) {
+		return GpuAllocation{ 0, 0, 0, NULL, -1 };
+	}
+
+	size_t offset;
+	for (size_t i = 0; i < arenaList.size(); i++) {
+		auto& arena = arenaList[i];
+		if (arena.allocator.allocate(size, alignment, offset)) {
+			return GpuAllocation{ arena.buffer, offset, size, arena.data ? arena.data + offset : NULL, int(i) };
+		}
+	}
+
+	int index = addArena(size + alignment > arenaSize ? size + alignment : arenaSize);
+	auto& arena = arenaList[index];
+	if (!arena.allocator.allocate(size, alignment, offset)) {
+		std::cout << "GPU Arena, can't fit " << size << " bytes" << std::endl;
+		return GpuAllocation{ 0, 0, 0, NULL, -1 };
+	}
+	return GpuAllocation{ arena.buffer, offset, size, arena.data ? arena.data + offset : NULL, index };
+}
+
+void GpuHeap::free(const GpuAllocation& allocation)
+{
+	if (allocation.buffer) {
+		freed.push_back(allocation);
+	}
+}
+
+void GpuHeap::write(const GpuAllocation& allocation, const void* data, size_t size, size_t offset)
+{
+	if (allocation.data) {
+		std::memcpy(allocation.data + offset, data, size);
+	}
+	else {
+		glBindBuffer(GL_COPY_WRITE_BUFFER, allocation.buffer);
+		glBufferSubData(GL_COPY_WRITE_BUFFER, allocation.offset + offset, size, data);
+	}
+}
+
+void GpuHeap::retire()
+{
+	if (!freed.empty()) {
+		retired.push_back(Retired{ glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), freed });
+		freed.clear();
+	}
+
+	// Fences signal in order, so stop at the first that hasn't.
+	size_t done = 0;
+	for (auto& r : retired) {
+		GLenum status = glClientWaitSync(r.fence, 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+			break;
+		}
+		glDeleteSync(r.fence);
+		for (auto& allocation : r.allocations) {
+			arenaList[allocation.arena].allocator.free(allocation.offset);
+		}
+		done++;
+	}
+	retired.erase(retired.begin(), retired.begin() + done);
+}
+
+size_t GpuHeap::uniformAlignment()
+{
+	GLint alignment = 256;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	return size_t(alignment);
+}
+
+bool GpuHeap::persistent() const
+{
+	return mapped;
+}
+
+size_t GpuHeap::arenas() const
+{
+	return arenaList.size();
+}
+
+size_t GpuHeap::used() const
+{
+	size_t total = 0;
+	for (auto& arena : arenaList) {
+		total += arena.allocator.used();
+	}
+	return total;
+}
@@ -0,0 +1,95 @@
+#ifndef GPU_HEAP_H
+#define GPU_HEAP_H
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <map>
+#include <vector>
+
+// Hands out byte ranges of a fixed-size space. Best fit from a size-ordered
+// free list, so allocation and free are O(log n), and freed neighbours
+// merge straight back.
+class OffsetAllocator {
+public:
+	OffsetAllocator(size_t size);
+
+	// Returns false when no free range is big enough.
+	bool allocate(size_t size, size_t alignment, size_t& offset);
+	void free(size_t offset);
+
+	size_t size() const;
+	size_t used() const;
+
+private:
+	size_t total;
+	size_t inUse;
+	std::map<size_t, size_t> freeByOffset;
+	std::multimap<size_t, size_t> freeBySize;
+	// offset -> size, including the alignment padding in front
+	std::map<size_t, std::pair<size_t, size_t>> allocations;
+
+	void insertFree(size_t offset, size_t size);
+	void eraseFree(std::map<size_t, size_t>::iterator it);
+};
+
+struct GpuAllocation {
+	GLuint buffer;
+	size_t offset;
+	size_t size;
+	// Persistently mapped memory for this range, NULL without buffer storage.
+	char* data;
+	int arena;
+};
+
+// Meshes, uniform blocks and other GPU data live as ranges of a few large
+// arena buffers instead of one buffer object each, so making a mesh is no
+// driver allocation and draws from one arena share bindings. With
+// ARB_buffer_storage the arenas are mapped persistently and coherently and
+// writes are plain memcpys; otherwise they go through glBufferSubData.
+class GpuHeap {
+public:
+	GpuHeap(size_t arenaSize = 16 << 20);
+	~GpuHeap();
+
+	// Anything larger than an arena gets an arena of its own. Zero bytes, or
+	// a range that can't be placed, give an allocation with buffer 0.
+	GpuAllocation allocate(size_t size, size_t alignment = 16);
+	// The range is reused only once the GPU is past every frame that might
+	// still read it, see retire().
+	void free(const GpuAllocation& allocation);
+	void write(const GpuAllocation& allocation, const void* data, size_t size, size_t offset = 0);
+
+	// Once per frame: fences the frees since the last call and reclaims
+	// those whose fence has signalled, without waiting.
+	void retire();
+
+	// For uniform block ranges bound with glBindBufferRange.
+	static size_t uniformAlignment();
+
+	bool persistent() const;
+	size_t arenas() const;
+	size_t used() const;
+
+private:
+	struct Arena {
+		GLuint buffer;
+		char* data;
+		OffsetAllocator allocator;
+	};
+
+	struct Retired {
+		GLsync fence;
+		std::vector<GpuAllocation> allocations;
+	};
+
+	size_t arenaSize;
+	bool mapped;
+	std::vector<Arena> arenaList;
+	std::vector<GpuAllocation> freed;
+	std::vector<Retired> retired;
+
+	int addArena(size_t size);
+};
+
+#endif // !GPU_HEAP_H
@@ -0,0 +1,168 @@
+#include "GpuProfiler.h"
+
+#include <iomanip>
+#include <sstream>
+
+GpuProfiler::GpuProfiler(int latency, int window)
+	: frames(latency > 1 ? latency : 2), frameNumber(0), lost(0), window(window > 0 ? window : 1)
+{
+	for (auto& frame : frames) {
+		frame.number = 0;
+		frame.used = 0;
+		frame.last = 0;
+		frame.pending = false;
+	}
+}
+
+GpuProfiler::~GpuProfiler()
+{
+	for (auto& frame : frames) {
+		for (auto& scope : frame.scopes) {
+			glDeleteQueries(1, &scope.begin);
+			glDeleteQueries(1, &scope.end);
+		}
+	}
+}
+
+GpuProfiler::Frame& GpuProfiler::current()
+{
+	return frames[frameNumber % frames.size()];
+}
+
+// Also drains whatever older frames have finished, so results arrive as soon
+// as the GPU has them rather than only when a slot is reused.
+void GpuProfiler::beginFrame()
+{
+	for (size_t i = 1; i < frames.size(); i++) {
+		auto& frame = frames[(frameNumber + i) % frames.size()];
+		if (frame.pending) {
+			collect(frame);
+		}
+	}
+
+	auto& frame = current();
+	if (frame.pending) {
+		collect(frame);
+		if (frame.pending) {
+			frame.pending = false;
+			lost++;
+		}
+	}
+
+	frame.number = frameNumber;
+	frame.used = 0;
+	open.clear();
+}
+
+void GpuProfiler::endFrame()
+{
+	while (!open.empty()) {
+		end();
+	}
+
+	current().pending = current().used > 0;
+	frameNumber++;
+}
+
+void GpuProfiler::begin(const char* name)
+{
+	auto& frame = current();
+	if (frame.used == frame.scopes.size()) {
+		Scope scope = { name, 0, 0 };
+		glGenQueries(1, &scope.begin);
+		glGenQueries(1, &scope.end);
+		frame.scopes.push_back(scope);
+	}
+
+	auto& scope = frame.scopes[frame.used];
+	scope.name = name;
+	glQueryCounter(scope.begin, GL_TIMESTAMP);
+	frame.last = scope.begin;
+	open.push_back(frame.used++);
+}
+
+void GpuProfiler::end()
+{
+	if (open.empty()) {
+		return;
+	}
+
+	auto& frame = current();
+	glQueryCounter(frame.scopes[open.back()].end, GL_TIMESTAMP);
+	frame.last = frame.scopes[open.back()].end;
+	open.pop_back();
+}
+
+void GpuProfiler::collect(Frame& frame)
+{
+	// Queries complete in order, so the last one issued stands for the
+	// frame. With nesting that is an outer scope's end, not the last scope's.
+	GLint available = 0;
+	glGetQueryObjectiv(frame.last, GL_QUERY_RESULT_AVAILABLE, &available);
+	if (!available) {
+		return;
+	}
+
+	for (size_t i = 0; i < frame.used; i++) {
+		auto& scope = frame.scopes[i];
+		GLuint64 begin = 0, end = 0;
+		glGetQueryObjectui64v(scope.begin, GL_QUERY_RESULT, &begin);
+		glGetQueryObjectui64v(scope.end, GL_QUERY_RESULT, &end);
+		double ms = (end - begin) / 1e6;
+
+		auto& s = stats[scope.name];
+		if (s.samples.empty()) {
+			s.samples.resize(window);
+			s.count = 0;
+		}
+		s.samples[s.count % s.samples.size()] = ms;
+		s.count++;
+
+		if (csv.is_open()) {
+			csv << frame.number << "," << scope.name << "," << ms << "\n";
+		}
+	}
+
+	frame.pending = false;
+}
+
+double GpuProfiler::average(const std::string& name) const
+{
+	auto found = stats.find(name);
+	if (found == stats.end() || found->second.count == 0) {
+		return 0;
+	}
+
+	auto& s = found->second;
+	size_t n = s.count < s.samples.size() ? s.count : s.samples.size();
+	double total = 0;
+	for (size_t i = 0; i < n; i++) {
+		total += s.samples[i];
+	}
+	return total / n;
+}
+
+std::string GpuProfiler::summary() const
+{
+	std::ostringstream out;
+	out << std::fixed << std::setprecision(3);
+	for (auto& entry : stats) {
+		out << entry.first << ": " << average(entry.first) << "ms\n";
+	}
+	return out.str();
+}
+
+bool GpuProfiler::logCsv(const char* path)
+{
+	csv.open(path);
+	if (!csv) {
+		return false;
+	}
+	csv << "frame,scope,ms\n";
+	return true;
+}
+
+unsigned GpuProfiler::dropped() const
+{
+	return lost;
+}
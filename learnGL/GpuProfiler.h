@@ -0,0 +1,79 @@
+#ifndef GPU_PROFILER_H
+#define GPU_PROFILER_H
+
+#include <glad/glad.h>
+
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+// Times GPU work with GL_TIMESTAMP queries. Each frame's queries sit in a
+// ring several frames deep and are only read once the driver reports them
+// available, so measuring never stalls the pipeline. Timestamps rather than
+// GL_TIME_ELAPSED let scopes nest.
+class GpuProfiler {
+public:
+	GpuProfiler(int latency = 4, int window = 60);
+	~GpuProfiler();
+
+	void beginFrame();
+	void endFrame();
+	// name must outlive the frame; string literals are expected.
+	void begin(const char* name);
+	void end();
+
+	// Mean GPU time of the scope over the recent window, in milliseconds.
+	double average(const std::string& name) const;
+	// One "scope: ms" line per scope, for showing on screen or printing.
+	std::string summary() const;
+	// Streams every collected result as frame,scope,ms rows.
+	bool logCsv(const char* path);
+	// Frames whose queries weren't ready by the time their slot came round.
+	unsigned dropped() const;
+
+private:
+	struct Scope {
+		const char* name;
+		GLuint begin;
+		GLuint end;
+	};
+
+	struct Frame {
+		unsigned number;
+		std::vector<Scope> scopes;
+		size_t used;
+		// The frame's most recent timestamp query.
+		GLuint last;
+		bool pending;
+	};
+
+	struct Stats {
+		std::vector<double> samples;
+		size_t count;
+	};
+
+	std::vector<Frame> frames;
+	std::vector<size_t> open;
+	std::map<std::string, Stats> stats;
+	std::ofstream csv;
+	unsigned frameNumber;
+	unsigned lost;
+	int window;
+
+	Frame& current();
+	void collect(Frame& frame);
+};
+
+// Times the enclosing block.
+struct GpuScope {
+	GpuProfiler& profiler;
+	GpuScope(GpuProfiler& profiler, const char* name) : profiler(profiler) {
+		profiler.begin(name);
+	}
+	~GpuScope() {
+		profiler.end();
+	}
+};
+
+#endif // !GPU_PROFILER_H
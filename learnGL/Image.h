@@ -2,6 +2,7 @@
 #define IMAGE_H
 
 #include "stb_image.h"
+#include "Profiler.h"
 #include <iostream>
 
 struct Image {
@@ -12,25 +13,30 @@ struct Image {
 	const char* path;
 };
 
-void bindImage(const char* path, void callback(Image im)) {
-	int width, height, nrChannels;
-	stbi_set_flip_vertically_on_load(true);
-	unsigned char* data = stbi_load(path, &width, &height, &nrChannels, 0);
+// Safe to call from any thread; data is NULL when the file couldn't be read.
+Image decodeImage(const char* path) {
+	PROFILE_ZONE("image decode");
+	Image im = { 0, 0, 0, NULL, path };
+	stbi_set_flip_vertically_on_load_thread(true);
+	im.data = stbi_load(path, &im.width, &im.height, &im.nrChannels, 0);
+	return im;
+}
 
-	if (data) {
-		callback(Image{
-			width,
-			height,
-			nrChannels,
-			data,
-			path
-			});
-		std::cout << "Load Image, " << path << "\t" << width << "x" << height << std::endl;
+// Hands a decoded image to callback for upload, then frees it.
+void bindImage(Image im, void callback(Image im)) {
+	if (im.data) {
+		PROFILE_ZONE("image upload");
+		callback(im);
+		std::cout << "Load Image, " << im.path << "\t" << im.width << "x" << im.height << std::endl;
 	}
 	else {
 		std::cout << "Failed to load texture" << std::endl;
 	}
 
-	stbi_image_free(data);
+	stbi_image_free(im.data);
+}
+
+void bindImage(const char* path, void callback(Image im)) {
+	bindImage(decodeImage(path), callback);
 }
 #endif // !IMAGE_H
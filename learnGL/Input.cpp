@@ -0,0 +1,127 @@
+#include "Input.h"
+
+#include <map>
+
+// GLFW callbacks are plain functions, so each window's Input is looked up
+// here rather than taking the window user pointer.
+std::map<GLFWwindow*, Input*> inputs;
+
+Input* inputFor(GLFWwindow* window) {
+	auto found = inputs.find(window);
+	return found != inputs.end() ? found->second : NULL;
+}
+
+Input::Input()
+	: window(NULL), hasPending(false), cursorX(0), cursorY(0), lost(0),
+	previousKey(NULL), previousMouseButton(NULL), previousCursorPos(NULL), previousScroll(NULL)
+{
+	for (auto& key : keys) {
+		key = false;
+	}
+}
+
+Input::~Input()
+{
+	if (window) {
+		inputs.erase(window);
+		glfwSetKeyCallback(window, previousKey);
+		glfwSetMouseButtonCallback(window, previousMouseButton);
+		glfwSetCursorPosCallback(window, previousCursorPos);
+		glfwSetScrollCallback(window, previousScroll);
+	}
+}
+
+void Input::attach(GLFWwindow* window)
+{
+	this->window = window;
+	inputs[window] = this;
+
+	previousKey = glfwSetKeyCallback(window, keyCallback);
+	previousMouseButton = glfwSetMouseButtonCallback(window, mouseButtonCallback);
+	previousCursorPos = glfwSetCursorPosCallback(window, cursorPosCallback);
+	previousScroll = glfwSetScrollCallback(window, scrollCallback);
+}
+
+bool Input::keyDown(int key) const
+{
+	return key >= 0 && key < KEYS && keys[key].load(std::memory_order_relaxed);
+}
+
+void Input::cursor(double& x, double& y) const
+{
+	x = cursorX.load(std::memory_order_relaxed);
+	y = cursorY.load(std::memory_order_relaxed);
+}
+
+unsigned Input::dropped() const
+{
+	return lost.load(std::memory_order_relaxed);
+}
+
+void Input::push(const InputEvent& event)
+{
+	if (!events.push(event)) {
+		lost.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+void Input::keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+	auto input = inputFor(window);
+	if (!input) {
+		return;
+	}
+
+	if (key >= 0 && key < KEYS && action != GLFW_REPEAT) {
+		input->keys[key].store(action == GLFW_PRESS, std::memory_order_relaxed);
+	}
+	input->push(InputEvent{ InputType::Key, key, action, mods, 0, 0, glfwGetTime() });
+
+	if (input->previousKey) {
+		input->previousKey(window, key, scancode, action, mods);
+	}
+}
+
+void Input::mouseButtonCallback(GLFWwindow* window, int button, int action, int mods)
+{
+	auto input = inputFor(window);
+	if (!input) {
+		return;
+	}
+
+	input->push(InputEvent{ InputType::MouseButton, button, action, mods, 0, 0, glfwGetTime() });
+
+	if (input->previousMouseButton) {
+		input->previousMouseButton(window, button, action, mods);
+	}
+}
+
+void Input::cursorPosCallback(GLFWwindow* window, double x, double y)
+{
+	auto input = inputFor(window);
+	if (!input) {
+		return;
+	}
+
+	input->cursorX.store(x, std::memory_order_relaxed);
+	input->cursorY.store(y, std::memory_order_relaxed);
+	input->push(InputEvent{ InputType::CursorPos, 0, 0, 0, x, y, glfwGetTime() });
+
+	if (input->previousCursorPos) {
+		input->previousCursorPos(window, x, y);
+	}
+}
+
+void Input::scrollCallback(GLFWwindow* window, double x, double y)
+{
+	auto input = inputFor(window);
+	if (!input) {
+		return;
+	}
+
+	input->push(InputEvent{ InputType::Scroll, 0, 0, 0, x, y, glfwGetTime() });
+
+	if (input->previousScroll) {
+		input->previousScroll(window, x, y);
+	}
+}
@@ -0,0 +1,84 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <GLFW/glfw3.h>
+#include "Queue.h"
+
+#include <atomic>
+#include <cstdint>
+
+enum class InputType : uint8_t {
+	Key,
+	MouseButton,
+	CursorPos,
+	Scroll,
+};
+
+// code is the key or mouse button; x, y the cursor position or scroll
+// offset. time is glfwGetTime() when the callback ran.
+struct InputEvent {
+	InputType type;
+	int code;
+	int action;
+	int mods;
+	double x;
+	double y;
+	double time;
+};
+
+// Collects every input transition through GLFW callbacks instead of
+// sampling once per frame, so nothing between frames is lost. Events queue
+// up in order and the simulation takes them at fixed-step boundaries; the
+// latest key and cursor state can also be read right before rendering.
+// Callbacks already on the window keep being called.
+class Input {
+public:
+	Input();
+	~Input();
+	void attach(GLFWwindow* window);
+
+	// Hands handle(const InputEvent&) every event stamped at or before time,
+	// oldest first. Call from one thread only.
+	template <typename Handle>
+	void consume(double time, Handle handle) {
+		while (hasPending || events.pop(pending)) {
+			if (pending.time > time) {
+				hasPending = true;
+				return;
+			}
+			hasPending = false;
+			handle(pending);
+		}
+	}
+
+	bool keyDown(int key) const;
+	void cursor(double& x, double& y) const;
+	// Events lost because the queue was full.
+	unsigned dropped() const;
+
+private:
+	static const int KEYS = 512;
+
+	GLFWwindow* window;
+	SpscQueue<InputEvent, 1024> events;
+	InputEvent pending;
+	bool hasPending;
+	std::atomic<bool> keys[KEYS];
+	std::atomic<double> cursorX;
+	std::atomic<double> cursorY;
+	std::atomic<unsigned> lost;
+
+	GLFWkeyfun previousKey;
+	GLFWmousebuttonfun previousMouseButton;
+	GLFWcursorposfun previousCursorPos;
+	GLFWscrollfun previousScroll;
+
+	void push(const InputEvent& event);
+
+	static void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
+	static void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
+	static void cursorPosCallback(GLFWwindow* window, double x, double y);
+	static void scrollCallback(GLFWwindow* window, double x, double y);
+};
+
+#endif // !INPUT_H
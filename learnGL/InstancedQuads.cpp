@@ -0,0 +1,101 @@
+#include "InstancedQuads.h"
+
+struct UnitQuadVertex {
+	float position[2];
+	float uv[2];
+
+	static constexpr std::array<VertexAttribute, 2> layout() {
+		return { {
+			VERTEX_ATTRIBUTE(UnitQuadVertex, position, 0),
+			VERTEX_ATTRIBUTE(UnitQuadVertex, uv, 2),
+		} };
+	}
+};
+
+InstancedQuads::InstancedQuads() : instanceBuffer(0), count(0), capacity(0)
+{
+	const UnitQuadVertex quad[] = {
+		{ {  0.5f,  0.5f }, { 1, 1 } },
+		{ {  0.5f, -0.5f }, { 1, 0 } },
+		{ { -0.5f, -0.5f }, { 0, 0 } },
+		{ { -0.5f,  0.5f }, { 0, 1 } },
+	};
+	const uint16_t indices[] = { 0, 1, 3, 1, 2, 3 };
+
+	glGenBuffers(1, &quadBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, quadBuffer);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+	glGenBuffers(1, &indexBuffer);
+	glGenBuffers(1, &instanceBuffer);
+
+	// Same quad in both; only the instanced one streams instances.
+	for (GLuint* vao : { &instancedArray, &singleArray }) {
+		glGenVertexArrays(1, vao);
+		glBindVertexArray(*vao);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+		glBindBuffer(GL_ARRAY_BUFFER, quadBuffer);
+		setVertexLayout<UnitQuadVertex>();
+	}
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+
+	glBindVertexArray(instancedArray);
+	glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+	setVertexLayout<QuadInstance>(0, 1);
+	glBindVertexArray(0);
+}
+
+InstancedQuads::~InstancedQuads()
+{
+	glDeleteVertexArrays(1, &instancedArray);
+	glDeleteVertexArrays(1, &singleArray);
+	glDeleteBuffers(1, &quadBuffer);
+	glDeleteBuffers(1, &indexBuffer);
+	glDeleteBuffers(1, &instanceBuffer);
+}
+
+void InstancedQuads::set(const QuadInstance* instances, size_t count)
+{
+	this->count = count;
+	size_t size = count * sizeof(QuadInstance);
+
+	glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+	if (count > capacity) {
+		capacity = count;
+		glBufferData(GL_ARRAY_BUFFER, size, instances, GL_STREAM_DRAW);
+	}
+	else {
+		glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(QuadInstance), NULL, GL_STREAM_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, size, instances);
+	}
+}
+
+void InstancedQuads::draw() const
+{
+	if (count == 0) {
+		return;
+	}
+
+	glBindVertexArray(instancedArray);
+	glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, 0, GLsizei(count));
+}
+
+void InstancedQuads::drawSeparately(const QuadInstance* instances, size_t count) const
+{
+	// With their arrays disabled, the instance attributes read the current
+	// constant values, so the same shader serves both paths.
+	glBindVertexArray(singleArray);
+	for (size_t i = 0; i < count; i++) {
+		auto& q = instances[i];
+		glVertexAttrib2f(3, q.offset[0], q.offset[1]);
+		glVertexAttrib2f(4, q.scale[0], q.scale[1]);
+		glVertexAttrib1f(5, q.rotation);
+		glVertexAttrib4Nub(6, q.tint[0].value, q.tint[1].value, q.tint[2].value, q.tint[3].value);
+		glVertexAttribI1ui(7, q.layer);
+		glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, 0);
+	}
+}
+
+GLuint InstancedQuads::vertexArray() const
+{
+	return instancedArray;
+}
@@ -0,0 +1,58 @@
+#ifndef INSTANCED_QUADS_H
+#define INSTANCED_QUADS_H
+
+#include <glad/glad.h>
+#include "VertexLayout.h"
+
+#include <array>
+#include <cstdint>
+
+// One textured quad; the shared unit quad is scaled, rotated and moved by
+// it in the vertex shader (instanced.vs). layer picks the slice of the
+// sampler2DArray.
+struct QuadInstance {
+	float offset[2];
+	float scale[2];
+	float rotation;
+	Unorm8 tint[4];
+	uint32_t layer;
+
+	static constexpr std::array<VertexAttribute, 5> layout() {
+		return { {
+			VERTEX_ATTRIBUTE(QuadInstance, offset, 3),
+			VERTEX_ATTRIBUTE(QuadInstance, scale, 4),
+			VERTEX_ATTRIBUTE(QuadInstance, rotation, 5),
+			VERTEX_ATTRIBUTE(QuadInstance, tint, 6),
+			VERTEX_ATTRIBUTE(QuadInstance, layer, 7),
+		} };
+	}
+};
+
+// Draws any number of quads with one glDrawElementsInstanced. The unit quad
+// streams per vertex and the instances per quad through
+// glVertexAttribDivisor.
+class InstancedQuads {
+public:
+	InstancedQuads();
+	~InstancedQuads();
+
+	// Replaces the instances; the old storage is orphaned, not waited on.
+	void set(const QuadInstance* instances, size_t count);
+	void draw() const;
+	// One glDrawElements per quad with the instance passed as constant
+	// attributes instead, for comparison.
+	void drawSeparately(const QuadInstance* instances, size_t count) const;
+
+	GLuint vertexArray() const;
+
+private:
+	GLuint instancedArray;
+	GLuint singleArray;
+	GLuint quadBuffer;
+	GLuint indexBuffer;
+	GLuint instanceBuffer;
+	size_t count;
+	size_t capacity;
+};
+
+#endif // !INSTANCED_QUADS_H
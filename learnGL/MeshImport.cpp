@@ -0,0 +1,909 @@
+#include "MeshImport.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const char* path) : bytes(NULL), length(0)
+#ifdef _WIN32
+	, file(INVALID_HANDLE_VALUE), mapping(NULL)
+#endif
+{
+#ifdef _WIN32
+	file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	LARGE_INTEGER size;
+	if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+		return;
+	}
+	mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping) {
+		bytes = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+		length = bytes ? size_t(size.QuadPart) : 0;
+	}
+#else
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		return;
+	}
+	struct stat info;
+	if (fstat(fd, &info) == 0 && info.st_size > 0) {
+		void* view = mmap(NULL, size_t(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+		if (view != MAP_FAILED) {
+			// Every page gets read, by several threads at once, so ask for
+			// read-ahead of the whole file.
+			madvise(view, size_t(info.st_size), MADV_WILLNEED);
+			bytes = static_cast<const char*>(view);
+			length = size_t(info.st_size);
+		}
+	}
+	// The mapping keeps the file open.
+	close(fd);
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+#ifdef _WIN32
+	if (bytes) {
+		UnmapViewOfFile(bytes);
+	}
+	if (mapping) {
+		CloseHandle(mapping);
+	}
+	if (file != INVALID_HANDLE_VALUE) {
+		CloseHandle(file);
+	}
+#else
+	if (bytes) {
+		munmap(const_cast<char*>(bytes), length);
+	}
+#endif
+}
+
+const char* MappedFile::data() const
+{
+	return bytes;
+}
+
+size_t MappedFile::size() const
+{
+	return length;
+}
+
+bool importMesh(const char* path, ImportedMesh& mesh) {
+	PROFILE_ZONE("mesh import");
+	auto start = std::chrono::steady_clock::now();
+
+	std::string extension = path;
+	extension = extension.substr(extension.find_last_of('.') == std::string::npos ? extension.size() : extension.find_last_of('.'));
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return char(std::tolower((unsigned char)c)); });
+
+	bool imported;
+	if (extension == ".obj") {
+		imported = importObj(path, mesh);
+	}
+	else if (extension == ".gltf" || extension == ".glb") {
+		imported = importGltf(path, mesh);
+	}
+	else {
+		std::cout << "Import Mesh, unknown format, " << path << std::endl;
+		return false;
+	}
+
+	if (imported) {
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		std::cout << "Import Mesh, " << path << "\t" << mesh.vertices.size() << " vertices, "
+			<< mesh.indices.size() / 3 << " triangles, " << ms << "ms" << std::endl;
+	}
+	return imported;
+}
+
+// Runs task(i) for i in [0, count) on up to one thread per core; the
+// calling thread takes a share too.
+template <typename Task>
+void parallelFor(size_t count, Task task) {
+	size_t threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+	std::vector<std::future<void>> running;
+	for (size_t t = 1; t < threads && t < count; t++) {
+		running.push_back(std::async(std::launch::async, [t, threads, count, &task]() {
+			for (size_t i = t; i < count; i += threads) {
+				task(i);
+			}
+		}));
+	}
+	for (size_t i = 0; i < count; i += threads) {
+		task(i);
+	}
+	for (auto& r : running) {
+		r.get();
+	}
+}
+
+const char* skipBlanks(const char* p, const char* end) {
+	while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) {
+		p++;
+	}
+	return p;
+}
+
+// Leaves value alone when there is no number, e.g. an optional component.
+const char* parseFloat(const char* p, const char* end, float& value) {
+	p = skipBlanks(p, end);
+	if (p < end && *p == '+') {
+		p++;
+	}
+	return std::from_chars(p, end, value).ptr;
+}
+
+// A face corner as written: position, uv and normal numbers, either
+// absolute and 0-based, or, where the matching bit of relative is set,
+// counted from the start of the chunk it was parsed in. Relative ones can
+// only be made absolute once all the chunks before are counted.
+struct ObjCorner {
+	int32_t index[3];
+	uint8_t relative;
+};
+
+const int32_t OBJ_MISSING = INT32_MIN;
+const uint32_t OBJ_NONE = 0xFFFFFFFF;
+
+struct ObjChunk {
+	std::vector<float> positions;
+	std::vector<float> uvs;
+	std::vector<float> normals;
+	// Three per triangle.
+	std::vector<ObjCorner> corners;
+	size_t badFaces = 0;
+};
+
+// Returns false for a malformed corner.
+bool parseObjCorner(const char*& p, const char* end, const ObjChunk& chunk, ObjCorner& corner) {
+	corner = ObjCorner{ { OBJ_MISSING, OBJ_MISSING, OBJ_MISSING }, 0 };
+	size_t counts[] = { chunk.positions.size() / 3, chunk.uvs.size() / 2, chunk.normals.size() / 3 };
+
+	for (int slot = 0; slot < 3; slot++) {
+		if (slot > 0) {
+			if (p == end || *p != '/') {
+				break;
+			}
+			p++;
+			// Empty, as the uv in "1//1".
+			if (p < end && *p == '/') {
+				continue;
+			}
+		}
+
+		long long number = 0;
+		auto result = std::from_chars(p, end, number);
+		if (result.ec != std::errc() || number == 0 || number > INT32_MAX || number < INT32_MIN + 1) {
+			return false;
+		}
+		p = result.ptr;
+
+		if (number > 0) {
+			corner.index[slot] = int32_t(number - 1);
+		}
+		else {
+			corner.index[slot] = int32_t((long long)counts[slot] + number);
+			corner.relative |= 1 << slot;
+		}
+	}
+
+	return corner.index[0] != OBJ_MISSING && (p == end || *p == ' ' || *p == '\t' || *p == '\r');
+}
+
+void parseObjFace(const char* p, const char* end, ObjChunk& chunk, std::vector<ObjCorner>& polygon) {
+	polygon.clear();
+	while ((p = skipBlanks(p, end)) < end) {
+		ObjCorner corner;
+		if (!parseObjCorner(p, end, chunk, corner)) {
+			chunk.badFaces++;
+			return;
+		}
+		polygon.push_back(corner);
+	}
+
+	// A fan, which is right for the convex polygons exporters write.
+	for (size_t i = 2; i < polygon.size(); i++) {
+		chunk.corners.push_back(polygon[0]);
+		chunk.corners.push_back(polygon[i - 1]);
+		chunk.corners.push_back(polygon[i]);
+	}
+}
+
+void parseObjChunk(const char* p, const char* end, ObjChunk& chunk) {
+	PROFILE_ZONE("obj chunk");
+	std::vector<ObjCorner> polygon;
+
+	while (p < end) {
+		const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', size_t(end - p)));
+		lineEnd = lineEnd ? lineEnd : end;
+		p = skipBlanks(p, lineEnd);
+
+		if (lineEnd - p > 2 && p[0] == 'v') {
+			float v[3] = { 0, 0, 0 };
+			if (p[1] == ' ' || p[1] == '\t') {
+				parseFloat(parseFloat(parseFloat(p + 2, lineEnd, v[0]), lineEnd, v[1]), lineEnd, v[2]);
+				chunk.positions.insert(chunk.positions.end(), v, v + 3);
+			}
+			else if (p[1] == 't' && (p[2] == ' ' || p[2] == '\t')) {
+				parseFloat(parseFloat(p + 3, lineEnd, v[0]), lineEnd, v[1]);
+				chunk.uvs.insert(chunk.uvs.end(), v, v + 2);
+			}
+			else if (p[1] == 'n' && (p[2] == ' ' || p[2] == '\t')) {
+				parseFloat(parseFloat(parseFloat(p + 3, lineEnd, v[0]), lineEnd, v[1]), lineEnd, v[2]);
+				chunk.normals.insert(chunk.normals.end(), v, v + 3);
+			}
+		}
+		else if (lineEnd - p > 1 && p[0] == 'f' && (p[1] == ' ' || p[1] == '\t')) {
+			parseObjFace(p + 2, lineEnd, chunk, polygon);
+		}
+
+		p = lineEnd + 1;
+	}
+}
+
+uint32_t hashCorner(const uint32_t* key) {
+	uint32_t h = key[0] * 0x9E3779B1u;
+	h = (h ^ (h >> 15) ^ key[1]) * 0x85EBCA77u;
+	h = (h ^ (h >> 13) ^ key[2]) * 0xC2B2AE3Du;
+	return h ^ (h >> 16);
+}
+
+bool importObj(const char* path, ImportedMesh& mesh) {
+	MappedFile file(path);
+	if (!file.data()) {
+		std::cout << "Import Mesh, failed to read " << path << std::endl;
+		return false;
+	}
+
+	// One chunk per core, but not so small that the threads cost more than
+	// they save, each ending just after a line break.
+	const char* data = file.data();
+	size_t threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+	size_t chunkSize = std::max<size_t>(file.size() / threads + 1, 1 << 16);
+	std::vector<std::pair<size_t, size_t>> ranges;
+	for (size_t start = 0; start < file.size();) {
+		size_t end = std::min(start + chunkSize, file.size());
+		auto lineEnd = static_cast<const char*>(std::memchr(data + end, '\n', file.size() - end));
+		end = lineEnd ? size_t(lineEnd - data) + 1 : file.size();
+		ranges.push_back(std::make_pair(start, end));
+		start = end;
+	}
+
+	std::vector<ObjChunk> chunks(ranges.size());
+	parallelFor(chunks.size(), [&](size_t i) {
+		parseObjChunk(data + ranges[i].first, data + ranges[i].second, chunks[i]);
+	});
+
+	// Where each chunk's positions, uvs, normals and corners start overall.
+	std::vector<size_t> bases((chunks.size() + 1) * 4, 0);
+	size_t badFaces = 0;
+	for (size_t i = 0; i < chunks.size(); i++) {
+		bases[(i + 1) * 4 + 0] = bases[i * 4 + 0] + chunks[i].positions.size() / 3;
+		bases[(i + 1) * 4 + 1] = bases[i * 4 + 1] + chunks[i].uvs.size() / 2;
+		bases[(i + 1) * 4 + 2] = bases[i * 4 + 2] + chunks[i].normals.size() / 3;
+		bases[(i + 1) * 4 + 3] = bases[i * 4 + 3] + chunks[i].corners.size();
+		badFaces += chunks[i].badFaces;
+	}
+	const size_t* totals = &bases[chunks.size() * 4];
+
+	// Resolve every corner to absolute numbers, OBJ_NONE where left out.
+	std::vector<uint32_t> keys(totals[3] * 3);
+	std::vector<char> outOfRange(chunks.size(), 0);
+	parallelFor(chunks.size(), [&](size_t c) {
+		uint32_t* key = keys.data() + bases[c * 4 + 3] * 3;
+		for (auto& corner : chunks[c].corners) {
+			for (int slot = 0; slot < 3; slot++) {
+				int32_t index = corner.index[slot];
+				if (index == OBJ_MISSING) {
+					*key++ = OBJ_NONE;
+					continue;
+				}
+
+				long long absolute = (corner.relative >> slot) & 1 ? (long long)bases[c * 4 + slot] + index : index;
+				if (absolute < 0 || size_t(absolute) >= totals[slot]) {
+					outOfRange[c] = 1;
+					absolute = 0;
+				}
+				*key++ = uint32_t(absolute);
+			}
+		}
+	});
+
+	if (std::find(outOfRange.begin(), outOfRange.end(), 1) != outOfRange.end()) {
+		std::cout << "Import Mesh, face refers past the end of the vertex lists in " << path << std::endl;
+		return false;
+	}
+	if (badFaces) {
+		std::cout << "Import Mesh, skipped " << badFaces << " malformed faces in " << path << std::endl;
+	}
+
+	// Corners with the same position/uv/normal become one vertex. Open
+	// addressing with linear probing; a slot holds a vertex number + 1, 0
+	// being empty, and the keys themselves are read back from the corner
+	// that made the vertex, so the table is one flat array of 4-byte slots
+	// kept under half full.
+	size_t cornerCount = totals[3];
+	size_t capacity = 16;
+	while (capacity < cornerCount * 2) {
+		capacity <<= 1;
+	}
+	size_t mask = capacity - 1;
+	std::vector<uint32_t> slots(capacity, 0);
+	std::vector<uint32_t> firstCorner;
+	firstCorner.reserve(totals[0]);
+	mesh.indices.resize(cornerCount);
+	{
+		PROFILE_ZONE("obj weld");
+		for (size_t i = 0; i < cornerCount; i++) {
+			const uint32_t* key = &keys[i * 3];
+			for (size_t h = hashCorner(key) & mask;; h = (h + 1) & mask) {
+				uint32_t slot = slots[h];
+				if (slot == 0) {
+					firstCorner.push_back(uint32_t(i));
+					slots[h] = uint32_t(firstCorner.size());
+					mesh.indices[i] = unsigned(firstCorner.size() - 1);
+					break;
+				}
+				if (std::memcmp(&keys[firstCorner[slot - 1] * size_t(3)], key, sizeof(uint32_t) * 3) == 0) {
+					mesh.indices[i] = slot - 1;
+					break;
+				}
+			}
+		}
+	}
+
+	// The attribute lists back to back, so a key indexes them directly.
+	std::vector<float> positions, uvs, normals;
+	positions.reserve(totals[0] * 3);
+	uvs.reserve(totals[1] * 2);
+	normals.reserve(totals[2] * 3);
+	for (auto& chunk : chunks) {
+		positions.insert(positions.end(), chunk.positions.begin(), chunk.positions.end());
+		uvs.insert(uvs.end(), chunk.uvs.begin(), chunk.uvs.end());
+		normals.insert(normals.end(), chunk.normals.begin(), chunk.normals.end());
+	}
+
+	mesh.vertices.assign(firstCorner.size(), ImportedVertex{});
+	size_t blocks = (mesh.vertices.size() + 65535) / 65536;
+	parallelFor(blocks, [&](size_t block) {
+		size_t last = std::min(mesh.vertices.size(), (block + 1) * 65536);
+		for (size_t v = block * 65536; v < last; v++) {
+			const uint32_t* key = &keys[firstCorner[v] * size_t(3)];
+			auto& vertex = mesh.vertices[v];
+			std::memcpy(vertex.position, &positions[key[0] * size_t(3)], sizeof(vertex.position));
+			if (key[1] != OBJ_NONE) {
+				std::memcpy(vertex.uv, &uvs[key[1] * size_t(2)], sizeof(vertex.uv));
+			}
+			if (key[2] != OBJ_NONE) {
+				std::memcpy(vertex.normal, &normals[key[2] * size_t(3)], sizeof(vertex.normal));
+			}
+		}
+	});
+
+	return true;
+}
+
+// Just enough of a JSON DOM for glTF. Numbers go through from_chars.
+struct JsonValue {
+	enum Type { Null, Bool, Number, String, Array, Object };
+
+	Type type = Null;
+	bool boolean = false;
+	double number = 0;
+	std::string string;
+	std::vector<JsonValue> items;
+	std::vector<std::pair<std::string, JsonValue>> members;
+
+	// A Null value when missing, so lookups chain.
+	const JsonValue& operator[](const char* key) const {
+		for (auto& member : members) {
+			if (member.first == key) {
+				return member.second;
+			}
+		}
+		return none();
+	}
+
+	const JsonValue& operator[](size_t index) const {
+		return index < items.size() ? items[index] : none();
+	}
+
+	bool has(const char* key) const {
+		return (*this)[key].type != Null;
+	}
+
+	size_t toSize(size_t fallback = 0) const {
+		return type == Number && number >= 0 ? size_t(number) : fallback;
+	}
+
+	static const JsonValue& none() {
+		static const JsonValue value;
+		return value;
+	}
+};
+
+struct JsonParser {
+	const char* p;
+	const char* end;
+	int depth = 0;
+
+	void skipSpace() {
+		while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) {
+			p++;
+		}
+	}
+
+	bool literal(const char* word) {
+		size_t length = std::strlen(word);
+		if (size_t(end - p) < length || std::memcmp(p, word, length) != 0) {
+			return false;
+		}
+		p += length;
+		return true;
+	}
+
+	static void appendUtf8(std::string& out, unsigned code) {
+		if (code < 0x80) {
+			out += char(code);
+		}
+		else if (code < 0x800) {
+			out += char(0xC0 | (code >> 6));
+			out += char(0x80 | (code & 0x3F));
+		}
+		else {
+			out += char(0xE0 | (code >> 12));
+			out += char(0x80 | ((code >> 6) & 0x3F));
+			out += char(0x80 | (code & 0x3F));
+		}
+	}
+
+	bool parseString(std::string& out) {
+		if (p == end || *p != '"') {
+			return false;
+		}
+		p++;
+		while (p < end && *p != '"') {
+			if (*p != '\\') {
+				out += *p++;
+				continue;
+			}
+			if (++p == end) {
+				return false;
+			}
+			char escape = *p++;
+			switch (escape)
+			{
+			case 'b': out += '\b'; break;
+			case 'f': out += '\f'; break;
+			case 'n': out += '\n'; break;
+			case 'r': out += '\r'; break;
+			case 't': out += '\t'; break;
+			case 'u': {
+				unsigned code = 0;
+				if (end - p < 4 || std::from_chars(p, p + 4, code, 16).ptr != p + 4) {
+					return false;
+				}
+				p += 4;
+				appendUtf8(out, code);
+				break;
+			}
+			default: out += escape; break;
+			}
+		}
+		if (p == end) {
+			return false;
+		}
+		p++;
+		return true;
+	}
+
+	bool parse(JsonValue& value) {
+		skipSpace();
+		if (p == end || ++depth > 64) {
+			return false;
+		}
+
+		bool ok = true;
+		switch (*p)
+		{
+		case '{':
+			value.type = JsonValue::Object;
+			p++;
+			skipSpace();
+			if (p < end && *p == '}') {
+				p++;
+				break;
+			}
+			while (ok) {
+				std::pair<std::string, JsonValue> member;
+				skipSpace();
+				ok = parseString(member.first);
+				skipSpace();
+				ok = ok && p < end && *p++ == ':' && parse(member.second);
+				value.members.push_back(std::move(member));
+				skipSpace();
+				if (ok && p < end && *p == ',') {
+					p++;
+					continue;
+				}
+				ok = ok && p < end && *p++ == '}';
+				break;
+			}
+			break;
+		case '[':
+			value.type = JsonValue::Array;
+			p++;
+			skipSpace();
+			if (p < end && *p == ']') {
+				p++;
+				break;
+			}
+			while (ok) {
+				value.items.emplace_back();
+				ok = parse(value.items.back());
+				skipSpace();
+				if (ok && p < end && *p == ',') {
+					p++;
+					continue;
+				}
+				ok = ok && p < end && *p++ == ']';
+				break;
+			}
+			break;
+		case '"':
+			value.type = JsonValue::String;
+			ok = parseString(value.string);
+			break;
+		case 't':
+		case 'f':
+			value.type = JsonValue::Bool;
+			value.boolean = *p == 't';
+			ok = literal(value.boolean ? "true" : "false");
+			break;
+		case 'n':
+			ok = literal("null");
+			break;
+		default: {
+			value.type = JsonValue::Number;
+			auto result = std::from_chars(p, end, value.number);
+			ok = result.ec == std::errc();
+			p = result.ptr;
+			break;
+		}
+		}
+
+		depth--;
+		return ok;
+	}
+};
+
+bool parseJson(const char* data, size_t size, JsonValue& root) {
+	JsonParser parser = { data, data + size };
+	return parser.parse(root);
+}
+
+bool decodeBase64(const char* p, const char* end, std::string& out) {
+	unsigned bits = 0;
+	int count = 0;
+	for (; p < end && *p != '='; p++) {
+		char c = *p;
+		int value = c >= 'A' && c <= 'Z' ? c - 'A'
+			: c >= 'a' && c <= 'z' ? c - 'a' + 26
+			: c >= '0' && c <= '9' ? c - '0' + 52
+			: c == '+' ? 62 : c == '/' ? 63 : -1;
+		if (value < 0) {
+			return false;
+		}
+		bits = (bits << 6) | unsigned(value);
+		count += 6;
+		if (count >= 8) {
+			count -= 8;
+			out += char((bits >> count) & 0xFF);
+		}
+	}
+	return true;
+}
+
+struct GltfBuffer {
+	const char* data;
+	size_t size;
+};
+
+// An accessor resolved to memory; data is NULL for one without a buffer
+// view, which reads as zeros.
+struct GltfAccessor {
+	const char* data;
+	size_t count;
+	size_t stride;
+	int componentType;
+	int components;
+	bool normalized;
+};
+
+size_t gltfComponentSize(int componentType) {
+	switch (componentType)
+	{
+	case 5120: // BYTE
+	case 5121: // UNSIGNED_BYTE
+		return 1;
+	case 5122: // SHORT
+	case 5123: // UNSIGNED_SHORT
+		return 2;
+	case 5125: // UNSIGNED_INT
+	case 5126: // FLOAT
+		return 4;
+	default:
+		return 0;
+	}
+}
+
+bool resolveAccessor(const JsonValue& gltf, const std::vector<GltfBuffer>& buffers, const JsonValue& index, GltfAccessor& accessor) {
+	const JsonValue& a = gltf["accessors"][index.toSize(SIZE_MAX)];
+	const std::string& type = a["type"].string;
+	accessor.components = type == "SCALAR" ? 1 : type == "VEC2" ? 2 : type == "VEC3" ? 3 : type == "VEC4" ? 4 : 0;
+	accessor.componentType = int(a["componentType"].number);
+	accessor.count = a["count"].toSize();
+	accessor.normalized = a["normalized"].boolean;
+	accessor.data = NULL;
+
+	size_t elementSize = gltfComponentSize(accessor.componentType) * accessor.components;
+	accessor.stride = elementSize;
+	if (elementSize == 0 || a.has("sparse")) {
+		return false;
+	}
+	if (!a.has("bufferView")) {
+		return true;
+	}
+
+	const JsonValue& view = gltf["bufferViews"][a["bufferView"].toSize(SIZE_MAX)];
+	size_t buffer = view["buffer"].toSize(SIZE_MAX);
+	if (buffer >= buffers.size()) {
+		return false;
+	}
+	accessor.stride = view["byteStride"].toSize(elementSize);
+
+	size_t offset = view["byteOffset"].toSize() + a["byteOffset"].toSize();
+	size_t needed = accessor.count ? accessor.stride * (accessor.count - 1) + elementSize : 0;
+	if (offset + needed > buffers[buffer].size || view["byteOffset"].toSize() + view["byteLength"].toSize() > buffers[buffer].size) {
+		return false;
+	}
+	accessor.data = buffers[buffer].data + offset;
+	return true;
+}
+
+// Component c of element i, with normalized integers mapped to [0, 1] or
+// [-1, 1] the way GL fetches them.
+float readGltfComponent(const GltfAccessor& accessor, size_t i, int c) {
+	if (!accessor.data || c >= accessor.components) {
+		return 0;
+	}
+
+	const char* p = accessor.data + i * accessor.stride + c * gltfComponentSize(accessor.componentType);
+	switch (accessor.componentType)
+	{
+	case 5120: {
+		int8_t v; std::memcpy(&v, p, 1);
+		return accessor.normalized ? std::max(v / 127.0f, -1.0f) : v;
+	}
+	case 5121: {
+		uint8_t v; std::memcpy(&v, p, 1);
+		return accessor.normalized ? v / 255.0f : v;
+	}
+	case 5122: {
+		int16_t v; std::memcpy(&v, p, 2);
+		return accessor.normalized ? std::max(v / 32767.0f, -1.0f) : v;
+	}
+	case 5123: {
+		uint16_t v; std::memcpy(&v, p, 2);
+		return accessor.normalized ? v / 65535.0f : v;
+	}
+	case 5125: {
+		uint32_t v; std::memcpy(&v, p, 4);
+		return float(v);
+	}
+	default: {
+		float v; std::memcpy(&v, p, 4);
+		return v;
+	}
+	}
+}
+
+uint32_t readGltfIndex(const GltfAccessor& accessor, size_t i) {
+	const char* p = accessor.data + i * accessor.stride;
+	switch (accessor.componentType)
+	{
+	case 5121:
+		return uint8_t(*p);
+	case 5123: {
+		uint16_t v; std::memcpy(&v, p, 2);
+		return v;
+	}
+	default: {
+		uint32_t v; std::memcpy(&v, p, 4);
+		return v;
+	}
+	}
+}
+
+bool convertGltfPrimitive(const JsonValue& gltf, const std::vector<GltfBuffer>& buffers, const JsonValue& primitive, ImportedMesh& out) {
+	PROFILE_ZONE("gltf primitive");
+	const JsonValue& attributes = primitive["attributes"];
+	GltfAccessor position, normal, uv, indices;
+	if (!resolveAccessor(gltf, buffers, attributes["POSITION"], position) || position.components != 3) {
+		return false;
+	}
+
+	bool hasNormal = attributes.has("NORMAL") && resolveAccessor(gltf, buffers, attributes["NORMAL"], normal) && normal.count == position.count;
+	bool hasUv = attributes.has("TEXCOORD_0") && resolveAccessor(gltf, buffers, attributes["TEXCOORD_0"], uv) && uv.count == position.count;
+
+	out.vertices.resize(position.count);
+	for (size_t i = 0; i < position.count; i++) {
+		auto& vertex = out.vertices[i];
+		for (int c = 0; c < 3; c++) {
+			vertex.position[c] = readGltfComponent(position, i, c);
+			vertex.normal[c] = hasNormal ? readGltfComponent(normal, i, c) : 0;
+		}
+		if (hasUv) {
+			vertex.uv[0] = readGltfComponent(uv, i, 0);
+			vertex.uv[1] = 1 - readGltfComponent(uv, i, 1);
+		}
+	}
+
+	if (!primitive.has("indices")) {
+		out.indices.resize(position.count / 3 * 3);
+		for (size_t i = 0; i < out.indices.size(); i++) {
+			out.indices[i] = unsigned(i);
+		}
+		return true;
+	}
+
+	if (!resolveAccessor(gltf, buffers, primitive["indices"], indices) || !indices.data || indices.components != 1
+		|| indices.componentType == 5126) {
+		return false;
+	}
+	out.indices.resize(indices.count / 3 * 3);
+	for (size_t i = 0; i < out.indices.size(); i++) {
+		uint32_t index = readGltfIndex(indices, i);
+		if (index >= position.count) {
+			return false;
+		}
+		out.indices[i] = index;
+	}
+	return true;
+}
+
+bool importGltf(const char* path, ImportedMesh& mesh) {
+	MappedFile file(path);
+	if (!file.data()) {
+		std::cout << "Import Mesh, failed to read " << path << std::endl;
+		return false;
+	}
+
+	// A .glb is a 12 byte header, then a JSON chunk and optionally a BIN
+	// chunk, each with its length and type up front.
+	const char* json = file.data();
+	size_t jsonSize = file.size();
+	GltfBuffer binary = { NULL, 0 };
+	if (file.size() >= 20 && std::memcmp(file.data(), "glTF", 4) == 0) {
+		uint32_t chunkLength, chunkType;
+		std::memcpy(&chunkLength, file.data() + 12, 4);
+		std::memcpy(&chunkType, file.data() + 16, 4);
+		if (chunkType != 0x4E4F534A || 20 + size_t(chunkLength) > file.size()) {
+			std::cout << "Import Mesh, malformed glb " << path << std::endl;
+			return false;
+		}
+		json = file.data() + 20;
+		jsonSize = chunkLength;
+
+		size_t next = 20 + size_t(chunkLength);
+		if (next + 8 <= file.size()) {
+			std::memcpy(&chunkLength, file.data() + next, 4);
+			std::memcpy(&chunkType, file.data() + next + 4, 4);
+			if (chunkType == 0x004E4942 && next + 8 + size_t(chunkLength) <= file.size()) {
+				binary = GltfBuffer{ file.data() + next + 8, chunkLength };
+			}
+		}
+	}
+
+	JsonValue gltf;
+	if (!parseJson(json, jsonSize, gltf) || gltf.type != JsonValue::Object) {
+		std::cout << "Import Mesh, malformed JSON in " << path << std::endl;
+		return false;
+	}
+
+	// Buffers are the glb's own BIN chunk, base64 data URIs, or files next
+	// to this one, mapped like it.
+	std::string directory = path;
+	size_t slash = directory.find_last_of("/\\");
+	directory = slash == std::string::npos ? "" : directory.substr(0, slash + 1);
+
+	std::vector<GltfBuffer> buffers;
+	std::vector<std::unique_ptr<MappedFile>> external;
+	std::vector<std::unique_ptr<std::string>> decoded;
+	for (auto& b : gltf["buffers"].items) {
+		const std::string& uri = b["uri"].string;
+		if (!b.has("uri")) {
+			buffers.push_back(binary);
+		}
+		else if (uri.compare(0, 5, "data:") == 0) {
+			size_t base64 = uri.find(";base64,");
+			decoded.emplace_back(new std::string());
+			if (base64 == std::string::npos || !decodeBase64(uri.data() + base64 + 8, uri.data() + uri.size(), *decoded.back())) {
+				std::cout << "Import Mesh, unsupported buffer URI in " << path << std::endl;
+				return false;
+			}
+			buffers.push_back(GltfBuffer{ decoded.back()->data(), decoded.back()->size() });
+		}
+		else {
+			external.emplace_back(new MappedFile((directory + uri).c_str()));
+			if (!external.back()->data()) {
+				std::cout << "Import Mesh, failed to read " << directory + uri << std::endl;
+				return false;
+			}
+			buffers.push_back(GltfBuffer{ external.back()->data(), external.back()->size() });
+		}
+	}
+
+	std::vector<const JsonValue*> primitives;
+	size_t skipped = 0;
+	for (auto& m : gltf["meshes"].items) {
+		for (auto& primitive : m["primitives"].items) {
+			// Only TRIANGLES, the default mode.
+			if (primitive["mode"].toSize(4) == 4) {
+				primitives.push_back(&primitive);
+			}
+			else {
+				skipped++;
+			}
+		}
+	}
+	if (skipped) {
+		std::cout << "Import Mesh, skipped " << skipped << " non-triangle primitives in " << path << std::endl;
+	}
+
+	std::vector<ImportedMesh> parts(primitives.size());
+	std::vector<char> converted(primitives.size(), 0);
+	parallelFor(primitives.size(), [&](size_t i) {
+		converted[i] = convertGltfPrimitive(gltf, buffers, *primitives[i], parts[i]);
+	});
+	if (std::find(converted.begin(), converted.end(), 0) != converted.end()) {
+		std::cout << "Import Mesh, unsupported or out of range accessor in " << path << std::endl;
+		return false;
+	}
+
+	// Each primitive is already indexed, so they are only concatenated.
+	mesh.vertices.clear();
+	mesh.indices.clear();
+	for (auto& part : parts) {
+		unsigned base = unsigned(mesh.vertices.size());
+		mesh.vertices.insert(mesh.vertices.end(), part.vertices.begin(), part.vertices.end());
+		for (unsigned index : part.indices) {
+			mesh.indices.push_back(base + index);
+		}
+	}
+	return true;
+}
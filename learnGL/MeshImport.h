@@ -0,0 +1,71 @@
+#ifndef MESH_IMPORT_H
+#define MESH_IMPORT_H
+
+#include "VertexLayout.h"
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+// A whole file mapped read-only into memory, so parsing reads the page
+// cache directly instead of copying through a stream.
+class MappedFile {
+public:
+	MappedFile(const char* path);
+	~MappedFile();
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// NULL when the file couldn't be opened or is empty.
+	const char* data() const;
+	size_t size() const;
+
+private:
+	const char* bytes;
+	size_t length;
+#ifdef _WIN32
+	void* file;
+	void* mapping;
+#endif
+};
+
+// Interleaved and tightly packed, ready for glBufferData or a GeometryPool.
+// Missing normals or uvs are left zero.
+struct ImportedVertex {
+	float position[3];
+	float normal[3];
+	float uv[2];
+
+	static constexpr std::array<VertexAttribute, 3> layout() {
+		return { {
+			VERTEX_ATTRIBUTE(ImportedVertex, position, 0),
+			VERTEX_ATTRIBUTE(ImportedVertex, normal, 1),
+			VERTEX_ATTRIBUTE(ImportedVertex, uv, 2),
+		} };
+	}
+};
+
+// Every triangle of the file as one indexed list; optimizeMesh can take it
+// from here.
+struct ImportedMesh {
+	std::vector<ImportedVertex> vertices;
+	std::vector<unsigned> indices;
+};
+
+// Picks the format from the extension: .obj, .gltf or .glb. Prints why and
+// returns false when the file can't be imported.
+bool importMesh(const char* path, ImportedMesh& mesh);
+
+// The file is split at line breaks into one chunk per core and the chunks
+// parsed in parallel. Faces are fanned into triangles, and corners repeating
+// the same position/uv/normal triple share a vertex. Negative (relative)
+// indices are supported; materials and groups are ignored.
+bool importObj(const char* path, ImportedMesh& mesh);
+
+// glTF 2.0, as .gltf with external or embedded base64 buffers, or .glb.
+// Every triangle primitive of every mesh is appended in mesh space, with
+// node transforms ignored; primitives convert in parallel. uvs are flipped
+// to GL's bottom-left origin, matching how Image.h loads textures.
+bool importGltf(const char* path, ImportedMesh& mesh);
+
+#endif // !MESH_IMPORT_H
@@ -0,0 +1,302 @@
+#include "MeshOptimizer.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+float acmr(const unsigned* indices, size_t count, int cacheSize) {
+	if (count < 3) {
+		return 0;
+	}
+
+	std::vector<unsigned> cache;
+	size_t misses = 0;
+	for (size_t i = 0; i < count; i++) {
+		if (std::find(cache.begin(), cache.end(), indices[i]) != cache.end()) {
+			continue;
+		}
+		misses++;
+		cache.insert(cache.begin(), indices[i]);
+		if (cache.size() > size_t(cacheSize)) {
+			cache.pop_back();
+		}
+	}
+
+	return float(misses) / float(count / 3);
+}
+
+// Forsyth's scoring: vertices just used score high, then less the further
+// they've drifted down the cache, and vertices with few triangles left get
+// a boost so they are finished off rather than stranded.
+const int SCORE_CACHE = 32;
+
+float vertexScore(int cachePosition, unsigned remaining) {
+	if (remaining == 0) {
+		return -1;
+	}
+
+	float score = 0;
+	if (cachePosition >= 0) {
+		score = cachePosition < 3
+			? 0.75f
+			: std::pow(1.0f - float(cachePosition - 3) / (SCORE_CACHE - 3), 1.5f);
+	}
+	return score + 2.0f / std::sqrt(float(remaining));
+}
+
+void optimizeVertexCache(unsigned* indices, size_t count, size_t vertexCount) {
+	PROFILE_ZONE("optimize vertex cache");
+	size_t triangles = count / 3;
+	if (triangles == 0) {
+		return;
+	}
+
+	// Triangles using each vertex, packed into one array.
+	std::vector<unsigned> remaining(vertexCount, 0);
+	for (size_t i = 0; i < triangles * 3; i++) {
+		remaining[indices[i]]++;
+	}
+	std::vector<size_t> first(vertexCount + 1, 0);
+	for (size_t v = 0; v < vertexCount; v++) {
+		first[v + 1] = first[v] + remaining[v];
+	}
+	std::vector<unsigned> adjacency(first[vertexCount]);
+	std::vector<size_t> filled(first.begin(), first.end() - 1);
+	for (size_t t = 0; t < triangles; t++) {
+		for (int k = 0; k < 3; k++) {
+			adjacency[filled[indices[t * 3 + k]]++] = unsigned(t);
+		}
+	}
+
+	std::vector<int> cachePosition(vertexCount, -1);
+	std::vector<float> score(vertexCount);
+	for (size_t v = 0; v < vertexCount; v++) {
+		score[v] = vertexScore(-1, remaining[v]);
+	}
+
+	std::vector<float> triangleScore(triangles);
+	for (size_t t = 0; t < triangles; t++) {
+		triangleScore[t] = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+	}
+
+	std::vector<unsigned> output;
+	output.reserve(triangles * 3);
+	std::vector<bool> emitted(triangles, false);
+	std::vector<unsigned> cache, next;
+	size_t cursor = 0;
+
+	long best = long(std::max_element(triangleScore.begin(), triangleScore.end()) - triangleScore.begin());
+	while (best >= 0) {
+		const unsigned* triangle = indices + best * 3;
+		output.insert(output.end(), triangle, triangle + 3);
+		emitted[best] = true;
+
+		// Unlink the triangle from its vertices.
+		for (int k = 0; k < 3; k++) {
+			unsigned v = triangle[k];
+			auto begin = adjacency.begin() + first[v];
+			auto end = begin + remaining[v];
+			std::iter_swap(std::find(begin, end, unsigned(best)), end - 1);
+			remaining[v]--;
+		}
+
+		// Its vertices move to the front of the cache; the rest shift down
+		// and whatever falls off the end is evicted.
+		next.assign(triangle, triangle + 3);
+		for (unsigned v : cache) {
+			if (v != triangle[0] && v != triangle[1] && v != triangle[2]) {
+				next.push_back(v);
+			}
+		}
+		for (size_t i = SCORE_CACHE; i < next.size(); i++) {
+			cachePosition[next[i]] = -1;
+			score[next[i]] = vertexScore(-1, remaining[next[i]]);
+		}
+		if (next.size() > size_t(SCORE_CACHE)) {
+			next.resize(SCORE_CACHE);
+		}
+		cache.swap(next);
+
+		for (size_t i = 0; i < cache.size(); i++) {
+			cachePosition[cache[i]] = int(i);
+			score[cache[i]] = vertexScore(int(i), remaining[cache[i]]);
+		}
+
+		// Only triangles touching the cache changed score.
+		best = -1;
+		float bestScore = -1;
+		for (unsigned v : cache) {
+			for (size_t i = first[v]; i < first[v] + remaining[v]; i++) {
+				unsigned t = adjacency[i];
+				float s = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+				triangleScore[t] = s;
+				if (s > bestScore) {
+					bestScore = s;
+					best = long(t);
+				}
+			}
+		}
+
+		// Nothing left near the cache: carry on from the next triangle not
+		// yet drawn.
+		if (best < 0) {
+			while (cursor < triangles && emitted[cursor]) {
+				cursor++;
+			}
+			best = cursor < triangles ? long(cursor) : -1;
+		}
+	}
+
+	std::copy(output.begin(), output.end(), indices);
+}
+
+void optimizeOverdraw(unsigned* indices, size_t count, const float* positions, size_t vertexCount, size_t stride) {
+	PROFILE_ZONE("optimize overdraw");
+	size_t triangles = count / 3;
+	if (triangles == 0 || vertexCount == 0) {
+		return;
+	}
+
+	// Split where a triangle misses the cache on all three vertices: the
+	// cache is effectively cold there, so reordering whole clusters keeps
+	// almost all of the cache pass's reuse.
+	std::vector<size_t> clusters;
+	std::vector<unsigned> cache;
+	for (size_t t = 0; t < triangles; t++) {
+		int misses = 0;
+		for (int k = 0; k < 3; k++) {
+			unsigned v = indices[t * 3 + k];
+			if (std::find(cache.begin(), cache.end(), v) == cache.end()) {
+				misses++;
+				cache.insert(cache.begin(), v);
+				if (cache.size() > 16) {
+					cache.pop_back();
+				}
+			}
+		}
+		if (misses == 3) {
+			clusters.push_back(t);
+		}
+	}
+	clusters.push_back(triangles);
+
+	float center[3] = { 0, 0, 0 };
+	for (size_t v = 0; v < vertexCount; v++) {
+		for (int axis = 0; axis < 3; axis++) {
+			center[axis] += positions[v * stride + axis] / float(vertexCount);
+		}
+	}
+
+	// Clusters facing out from the mesh center are more likely in front of
+	// the rest, so they are drawn first and occlude what comes after.
+	struct Cluster {
+		size_t begin;
+		size_t end;
+		float sort;
+	};
+	std::vector<Cluster> sorted;
+	for (size_t c = 0; c + 1 < clusters.size(); c++) {
+		float centroid[3] = { 0, 0, 0 }, normal[3] = { 0, 0, 0 };
+		for (size_t t = clusters[c]; t < clusters[c + 1]; t++) {
+			const float* p[3];
+			for (int k = 0; k < 3; k++) {
+				p[k] = positions + size_t(indices[t * 3 + k]) * stride;
+			}
+			float e1[3], e2[3];
+			for (int axis = 0; axis < 3; axis++) {
+				e1[axis] = p[1][axis] - p[0][axis];
+				e2[axis] = p[2][axis] - p[0][axis];
+				centroid[axis] += p[0][axis] + p[1][axis] + p[2][axis];
+			}
+			// Unnormalized, so bigger triangles weigh more.
+			normal[0] += e1[1] * e2[2] - e1[2] * e2[1];
+			normal[1] += e1[2] * e2[0] - e1[0] * e2[2];
+			normal[2] += e1[0] * e2[1] - e1[1] * e2[0];
+		}
+
+		float n = float(clusters[c + 1] - clusters[c]) * 3;
+		float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+		float sort = 0;
+		for (int axis = 0; axis < 3; axis++) {
+			sort += (centroid[axis] / n - center[axis]) * (length > 0 ? normal[axis] / length : 0);
+		}
+		sorted.push_back(Cluster{ clusters[c], clusters[c + 1], sort });
+	}
+
+	std::stable_sort(sorted.begin(), sorted.end(), [](const Cluster& a, const Cluster& b) {
+		return a.sort > b.sort;
+	});
+
+	std::vector<unsigned> output;
+	output.reserve(triangles * 3);
+	for (auto& cluster : sorted) {
+		output.insert(output.end(), indices + cluster.begin * 3, indices + cluster.end * 3);
+	}
+	std::copy(output.begin(), output.end(), indices);
+}
+
+size_t optimizeVertexFetch(void* vertices, unsigned* indices, size_t count, size_t vertexCount, size_t vertexSize) {
+	PROFILE_ZONE("optimize vertex fetch");
+	const unsigned UNUSED = ~0u;
+	std::vector<unsigned> remap(vertexCount, UNUSED);
+	std::vector<uint8_t> reordered;
+	reordered.reserve(vertexCount * vertexSize);
+
+	auto bytes = static_cast<const uint8_t*>(vertices);
+	unsigned used = 0;
+	for (size_t i = 0; i < count; i++) {
+		unsigned& index = remap[indices[i]];
+		if (index == UNUSED) {
+			index = used++;
+			auto vertex = bytes + size_t(indices[i]) * vertexSize;
+			reordered.insert(reordered.end(), vertex, vertex + vertexSize);
+		}
+		indices[i] = index;
+	}
+
+	std::memcpy(vertices, reordered.data(), reordered.size());
+	return used;
+}
+
+IndexData narrowIndices(const unsigned* indices, size_t count, bool allowBytes) {
+	unsigned largest = 0;
+	for (size_t i = 0; i < count; i++) {
+		largest = indices[i] > largest ? indices[i] : largest;
+	}
+
+	IndexData data;
+	if (allowBytes && largest <= 0xff) {
+		data.type = GL_UNSIGNED_BYTE;
+		data.bytes.assign(indices, indices + count);
+	}
+	else if (largest <= 0xffff) {
+		data.type = GL_UNSIGNED_SHORT;
+		data.bytes.resize(count * sizeof(uint16_t));
+		auto narrow = reinterpret_cast<uint16_t*>(data.bytes.data());
+		for (size_t i = 0; i < count; i++) {
+			narrow[i] = uint16_t(indices[i]);
+		}
+	}
+	else {
+		data.type = GL_UNSIGNED_INT;
+		auto wide = reinterpret_cast<const uint8_t*>(indices);
+		data.bytes.assign(wide, wide + count * sizeof(unsigned));
+	}
+	return data;
+}
+
+IndexData optimizeMesh(void* vertices, size_t& vertexCount, size_t vertexSize, unsigned* indices, size_t count) {
+	float before = acmr(indices, count);
+
+	optimizeVertexCache(indices, count, vertexCount);
+	optimizeOverdraw(indices, count, static_cast<const float*>(vertices), vertexCount, vertexSize / sizeof(float));
+	float after = acmr(indices, count);
+	vertexCount = optimizeVertexFetch(vertices, indices, count, vertexCount, vertexSize);
+
+	auto data = narrowIndices(indices, count);
+	std::cout << "Optimize Mesh, " << count / 3 << " triangles\tACMR " << before << " -> " << after
+		<< ", indices " << count * sizeof(unsigned) << " -> " << data.bytes.size() << " bytes" << std::endl;
+	return data;
+}
@@ -0,0 +1,49 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Offline-quality passes over an indexed triangle list, meant to run once
+// at load time. In the order optimizeMesh applies them:
+//
+// 1. optimizeVertexCache reorders triangles so recently transformed
+//    vertices get reused (Forsyth's linear-speed algorithm).
+// 2. optimizeOverdraw then reorders whole runs of triangles so outward
+//    facing ones tend to be drawn first, without splitting the runs the
+//    cache pass built.
+// 3. optimizeVertexFetch renumbers vertices in first-use order so fetches
+//    walk the vertex buffer forwards; unreferenced vertices are dropped.
+// 4. narrowIndices picks the smallest index type that fits.
+
+// Average cache misses per triangle for a FIFO post-transform cache. 3 is
+// the worst possible, 0.5 about the best a regular grid can reach.
+float acmr(const unsigned* indices, size_t count, int cacheSize = 16);
+
+void optimizeVertexCache(unsigned* indices, size_t count, size_t vertexCount);
+
+// positions holds x, y, z at the start of every vertex, stride floats apart.
+void optimizeOverdraw(unsigned* indices, size_t count, const float* positions, size_t vertexCount, size_t stride);
+
+// Reorders vertexCount vertices of vertexSize bytes in place and rewrites
+// the indices to match. Returns how many vertices are left.
+size_t optimizeVertexFetch(void* vertices, unsigned* indices, size_t count, size_t vertexCount, size_t vertexSize);
+
+// Indices ready for glBufferData, with the type to draw them with.
+struct IndexData {
+	GLenum type;
+	std::vector<uint8_t> bytes;
+};
+
+// Bytes are opt-in: a lot of hardware has no native 8-bit index fetch and
+// the driver converts them, which costs more than the memory saved.
+IndexData narrowIndices(const unsigned* indices, size_t count, bool allowBytes = false);
+
+// Runs all of the above and prints the ACMR before and after. vertices
+// start with three float positions.
+IndexData optimizeMesh(void* vertices, size_t& vertexCount, size_t vertexSize, unsigned* indices, size_t count);
+
+#endif // !MESH_OPTIMIZER_H
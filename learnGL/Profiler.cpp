@@ -0,0 +1,88 @@
+#include "Profiler.h"
+
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+struct Zone {
+	const char* name;
+	uint64_t start;
+	uint64_t duration;
+};
+
+// Written only by its own thread. count is published after each zone, so
+// writeTrace can read a live buffer up to count safely.
+struct ZoneBuffer {
+	static const size_t CAPACITY = 1 << 16;
+
+	unsigned thread;
+	std::atomic<size_t> count;
+	Zone zones[CAPACITY];
+};
+
+// Buffers outlive their threads so a trace can still be written after the
+// threads are gone. The lock is only taken once per thread.
+std::mutex buffersLock;
+std::vector<std::shared_ptr<ZoneBuffer>> buffers;
+
+ZoneBuffer& threadBuffer() {
+	thread_local std::shared_ptr<ZoneBuffer> buffer;
+	if (!buffer) {
+		buffer = std::make_shared<ZoneBuffer>();
+		buffer->count = 0;
+
+		std::lock_guard<std::mutex> lock(buffersLock);
+		buffer->thread = unsigned(buffers.size() + 1);
+		buffers.push_back(buffer);
+	}
+	return *buffer;
+}
+
+uint64_t profilerNow() {
+	static const auto start = std::chrono::steady_clock::now();
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+void recordZone(const char* name, uint64_t startNs, uint64_t durationNs) {
+	auto& buffer = threadBuffer();
+	size_t n = buffer.count.load(std::memory_order_relaxed);
+	if (n == ZoneBuffer::CAPACITY) {
+		return;
+	}
+
+	buffer.zones[n] = Zone{ name, startNs, durationNs };
+	buffer.count.store(n + 1, std::memory_order_release);
+}
+
+bool writeTrace(const char* path) {
+	std::ofstream out(path);
+	if (!out) {
+		std::cout << "Failed to write trace, " << path << std::endl;
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(buffersLock);
+	bool first = true;
+	size_t total = 0;
+
+	out << std::fixed << std::setprecision(3) << "{\"traceEvents\":[\n";
+	for (auto& buffer : buffers) {
+		size_t n = buffer->count.load(std::memory_order_acquire);
+		for (size_t i = 0; i < n; i++) {
+			auto& zone = buffer->zones[i];
+			out << (first ? "" : ",\n")
+				<< "{\"name\":\"" << zone.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->thread
+				<< ",\"ts\":" << zone.start / 1000.0 << ",\"dur\":" << zone.duration / 1000.0 << "}";
+			first = false;
+		}
+		total += n;
+	}
+	out << "\n]}\n";
+
+	std::cout << "Write Trace, " << path << "\t" << total << " zones" << std::endl;
+	return true;
+}
@@ -0,0 +1,42 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <chrono>
+#include <cstdint>
+
+// CPU zones for a Chrome/Perfetto timeline. Each thread appends to its own
+// fixed-size buffer, so recording takes no locks; zones past the buffer's
+// end are dropped. Zones are compiled in for debug builds, or anywhere
+// ENABLE_PROFILER is defined.
+#if defined(_DEBUG) || defined(ENABLE_PROFILER)
+#define PROFILER_ENABLED 1
+#endif
+
+// name must be a string literal or otherwise outlive the trace.
+void recordZone(const char* name, uint64_t startNs, uint64_t durationNs);
+uint64_t profilerNow();
+
+// Writes every recorded zone from every thread as Chrome trace JSON, which
+// chrome://tracing and ui.perfetto.dev open directly.
+bool writeTrace(const char* path);
+
+struct ProfileZone {
+	const char* name;
+	uint64_t start;
+
+	ProfileZone(const char* name) : name(name), start(profilerNow()) {}
+	~ProfileZone() {
+		recordZone(name, start, profilerNow() - start);
+	}
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+#ifdef PROFILER_ENABLED
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#else
+#define PROFILE_ZONE(name)
+#endif
+
+#endif // !PROFILER_H
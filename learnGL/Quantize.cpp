@@ -0,0 +1,120 @@
+#include "Quantize.h"
+
+#include <cmath>
+#include <cstring>
+
+float clamp(float value, float low, float high) {
+	return value < low ? low : value > high ? high : value;
+}
+
+// Snorm uses the c / (2^(b-1) - 1) mapping of GL 4.2 and later, which every
+// current driver also applies to 3.3 contexts; only it represents 0 exactly.
+
+Unorm8 toUnorm8(float value) {
+	return Unorm8{ uint8_t(std::lround(clamp(value, 0, 1) * 255)) };
+}
+
+Snorm8 toSnorm8(float value) {
+	return Snorm8{ int8_t(std::lround(clamp(value, -1, 1) * 127)) };
+}
+
+Unorm16 toUnorm16(float value) {
+	return Unorm16{ uint16_t(std::lround(clamp(value, 0, 1) * 65535)) };
+}
+
+Snorm16 toSnorm16(float value) {
+	return Snorm16{ int16_t(std::lround(clamp(value, -1, 1) * 32767)) };
+}
+
+Half toHalf(float value) {
+	uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+
+	uint32_t sign = (bits >> 16) & 0x8000;
+	uint32_t biased = (bits >> 23) & 0xff;
+	uint32_t mantissa = bits & 0x7fffff;
+	int exponent = int(biased) - 127 + 15;
+
+	if (biased == 0xff) {
+		return Half{ uint16_t(sign | 0x7c00 | (mantissa ? 0x200 : 0)) };
+	}
+	if (exponent >= 31) {
+		return Half{ uint16_t(sign | 0x7c00) };
+	}
+
+	uint32_t half, rest, midpoint;
+	if (exponent <= 0) {
+		// Subnormal, or too small for even that.
+		if (exponent < -10) {
+			return Half{ uint16_t(sign) };
+		}
+		mantissa |= 0x800000;
+		int shift = 14 - exponent;
+		half = mantissa >> shift;
+		rest = mantissa & ((1u << shift) - 1);
+		midpoint = 1u << (shift - 1);
+	}
+	else {
+		half = (uint32_t(exponent) << 10) | (mantissa >> 13);
+		rest = mantissa & 0x1fff;
+		midpoint = 0x1000;
+	}
+
+	// A carry out of the mantissa correctly bumps the exponent.
+	if (rest > midpoint || (rest == midpoint && (half & 1))) {
+		half++;
+	}
+	return Half{ uint16_t(sign | half) };
+}
+
+float fromHalf(Half value) {
+	uint32_t sign = uint32_t(value.bits & 0x8000) << 16;
+	uint32_t exponent = (value.bits >> 10) & 0x1f;
+	uint32_t mantissa = value.bits & 0x3ff;
+
+	uint32_t bits;
+	if (exponent == 0x1f) {
+		bits = sign | 0x7f800000 | (mantissa << 13);
+	}
+	else if (exponent != 0) {
+		bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+	}
+	else {
+		float subnormal = std::ldexp(float(mantissa), -24);
+		return sign ? -subnormal : subnormal;
+	}
+
+	float result;
+	std::memcpy(&result, &bits, sizeof(result));
+	return result;
+}
+
+PositionQuantization positionQuantization(const float* positions, size_t count, size_t stride) {
+	float low[3] = { 0, 0, 0 }, high[3] = { 0, 0, 0 };
+	for (size_t i = 0; i < count; i++) {
+		const float* p = positions + i * stride;
+		for (int axis = 0; axis < 3; axis++) {
+			if (i == 0 || p[axis] < low[axis]) {
+				low[axis] = p[axis];
+			}
+			if (i == 0 || p[axis] > high[axis]) {
+				high[axis] = p[axis];
+			}
+		}
+	}
+
+	PositionQuantization quantization;
+	for (int axis = 0; axis < 3; axis++) {
+		// A flat axis still needs a nonzero scale to divide by.
+		float extent = high[axis] - low[axis];
+		quantization.scale[axis] = extent > 0 ? extent : 1;
+		quantization.offset[axis] = low[axis];
+	}
+	return quantization;
+}
+
+void quantizePosition(const PositionQuantization& quantization, const float* position, Unorm16 out[3]) {
+	for (int axis = 0; axis < 3; axis++) {
+		out[axis] = toUnorm16((position[axis] - quantization.offset[axis]) / quantization.scale[axis]);
+	}
+}
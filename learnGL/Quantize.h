@@ -0,0 +1,34 @@
+#ifndef QUANTIZE_H
+#define QUANTIZE_H
+
+#include "VertexLayout.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// Packs float vertex data into the compact component types of
+// VertexLayout.h. Plain CPU code, so it serves an offline converter as well
+// as meshes packed at load time. Values outside a normalized type's range
+// are clamped, so UVs that repeat past [0, 1] want Half instead.
+
+Unorm8 toUnorm8(float value);
+Snorm8 toSnorm8(float value);
+Unorm16 toUnorm16(float value);
+Snorm16 toSnorm16(float value);
+// Rounds to nearest even; overflow becomes infinity.
+Half toHalf(float value);
+float fromHalf(Half value);
+
+// Maps a mesh's bounding box onto [0, 1] per axis for Unorm16 positions.
+// The vertex shader gets them back as position * scale + offset, which
+// keeps about 1/65535 of the box's size as precision.
+struct PositionQuantization {
+	float scale[3];
+	float offset[3];
+};
+
+// stride is in floats, e.g. 8 for interleaved pos/color/uv.
+PositionQuantization positionQuantization(const float* positions, size_t count, size_t stride = 3);
+void quantizePosition(const PositionQuantization& quantization, const float* position, Unorm16 out[3]);
+
+#endif // !QUANTIZE_H
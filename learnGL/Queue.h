@@ -0,0 +1,50 @@
+#ifndef QUEUE_H
+#define QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+
+// Bounded lock-free ring for exactly one producer and one consumer thread.
+// Holds Capacity - 1 items; push and pop never block and report whether
+// they succeeded.
+template <typename T, size_t Capacity>
+class SpscQueue {
+public:
+	SpscQueue() : head(0), tail(0) {}
+
+	bool push(const T& value) {
+		size_t t = tail.load(std::memory_order_relaxed);
+		size_t next = (t + 1) % Capacity;
+		if (next == head.load(std::memory_order_acquire)) {
+			return false;
+		}
+		items[t] = value;
+		tail.store(next, std::memory_order_release);
+		return true;
+	}
+
+	bool pop(T& value) {
+		size_t h = head.load(std::memory_order_relaxed);
+		if (h == tail.load(std::memory_order_acquire)) {
+			return false;
+		}
+		value = items[h];
+		head.store((h + 1) % Capacity, std::memory_order_release);
+		return true;
+	}
+
+	bool empty() const {
+		return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+	}
+
+	bool full() const {
+		return (tail.load(std::memory_order_acquire) + 1) % Capacity == head.load(std::memory_order_acquire);
+	}
+
+private:
+	T items[Capacity];
+	std::atomic<size_t> head;
+	std::atomic<size_t> tail;
+};
+
+#endif // !QUEUE_H
@@ -0,0 +1,136 @@
+#include "RenderTarget.h"
+
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+RenderTarget createRenderTarget(int width, int height) {
+	RenderTarget target = { 0, 0, 0, width, height, width, height };
+
+	glGenTextures(1, &target.color);
+	glBindTexture(GL_TEXTURE_2D, target.color);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	glGenRenderbuffers(1, &target.depth);
+	glBindRenderbuffer(GL_RENDERBUFFER, target.depth);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+
+	glGenFramebuffers(1, &target.framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, target.framebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target.color, 0);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, target.depth);
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+		std::cout << "ERROR::FRAMEBUFFER::INCOMPLETE " << width << "x" << height << std::endl;
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	return target;
+}
+
+void deleteRenderTarget(RenderTarget& target) {
+	glDeleteFramebuffers(1, &target.framebuffer);
+	glDeleteRenderbuffers(1, &target.depth);
+	glDeleteTextures(1, &target.color);
+	target = RenderTarget{ 0, 0, 0, 0, 0, 0, 0 };
+}
+
+bool writeRenderTarget(const RenderTarget& target, const char* path) {
+	std::vector<unsigned char> pixels(target.width * target.height * 3);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, target.framebuffer);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, target.width, target.height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+	std::ofstream file(path, std::ios::binary);
+	if (!file) {
+		std::cout << "Failed to write image, " << path << std::endl;
+		return false;
+	}
+
+	file << "P6\n" << target.width << " " << target.height << "\n255\n";
+	// GL rows start at the bottom.
+	for (int y = target.height - 1; y >= 0; y--) {
+		file.write(reinterpret_cast<const char*>(&pixels[y * target.width * 3]), target.width * 3);
+	}
+
+	std::cout << "Write Image, " << path << "\t" << target.width << "x" << target.height << std::endl;
+	return true;
+}
+
+int roundToBucket(int size) {
+	int buckets = (size + RenderTargetPool::BUCKET - 1) / RenderTargetPool::BUCKET;
+	return (buckets > 0 ? buckets : 1) * RenderTargetPool::BUCKET;
+}
+
+bool fits(const RenderTarget& target, int width, int height) {
+	return target.allocatedWidth >= width && target.allocatedHeight >= height;
+}
+
+RenderTargetPool::~RenderTargetPool()
+{
+	clear();
+}
+
+RenderTarget RenderTargetPool::acquire(int width, int height)
+{
+	int bucketWidth = roundToBucket(width);
+	int bucketHeight = roundToBucket(height);
+
+	// Take the smallest free target that fits, but not one over twice the
+	// bucket's area, which would just waste memory.
+	auto best = available.end();
+	for (auto it = available.begin(); it != available.end(); ++it) {
+		long area = long(it->allocatedWidth) * it->allocatedHeight;
+		if (fits(*it, width, height) && area <= 2L * bucketWidth * bucketHeight &&
+			(best == available.end() || area < long(best->allocatedWidth) * best->allocatedHeight)) {
+			best = it;
+		}
+	}
+
+	if (best != available.end()) {
+		auto target = *best;
+		available.erase(best);
+		target.width = width;
+		target.height = height;
+		return target;
+	}
+
+	auto target = createRenderTarget(bucketWidth, bucketHeight);
+	target.width = width;
+	target.height = height;
+	return target;
+}
+
+void RenderTargetPool::release(const RenderTarget& target)
+{
+	if (target.framebuffer) {
+		available.push_back(target);
+	}
+}
+
+void RenderTargetPool::resize(RenderTarget& target, int width, int height)
+{
+	if (fits(target, width, height)) {
+		target.width = width;
+		target.height = height;
+		return;
+	}
+
+	release(target);
+	target = acquire(width, height);
+}
+
+void RenderTargetPool::clear()
+{
+	for (auto& target : available) {
+		deleteRenderTarget(target);
+	}
+	available.clear();
+}
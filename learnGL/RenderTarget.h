@@ -0,0 +1,52 @@
+#ifndef RENDER_TARGET_H
+#define RENDER_TARGET_H
+
+#include <glad/glad.h>
+
+#include <vector>
+
+// Framebuffer with an RGBA8 color texture and a depth/stencil renderbuffer.
+// width x height is the area in use, which may be smaller than the
+// attachments when the target came from a RenderTargetPool.
+struct RenderTarget {
+	GLuint framebuffer;
+	GLuint color;
+	GLuint depth;
+	int width;
+	int height;
+	int allocatedWidth;
+	int allocatedHeight;
+};
+
+RenderTarget createRenderTarget(int width, int height);
+void deleteRenderTarget(RenderTarget& target);
+
+// Reads the color attachment back and saves it as a binary PPM, top row
+// first, e.g. for golden-image comparisons.
+bool writeRenderTarget(const RenderTarget& target, const char* path);
+
+// Hands out targets with sizes rounded up to BUCKET pixels and keeps released
+// ones for reuse, so shrinking or growing within a bucket costs nothing and
+// a drag-resize doesn't reallocate every frame.
+class RenderTargetPool {
+public:
+	static const int BUCKET = 128;
+
+	RenderTargetPool() = default;
+	~RenderTargetPool();
+	// Owns its framebuffers, so copies would delete them twice.
+	RenderTargetPool(const RenderTargetPool&) = delete;
+	RenderTargetPool& operator=(const RenderTargetPool&) = delete;
+
+	RenderTarget acquire(int width, int height);
+	void release(const RenderTarget& target);
+	// Changes the size in use, reallocating only when it no longer fits.
+	void resize(RenderTarget& target, int width, int height);
+	// Deletes every released target.
+	void clear();
+
+private:
+	std::vector<RenderTarget> available;
+};
+
+#endif // !RENDER_TARGET_H
@@ -0,0 +1,113 @@
+#ifndef RENDER_THREAD_H
+#define RENDER_THREAD_H
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include "Queue.h"
+#include "Profiler.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// Owns the window's GL context on its own thread and draws each Frame the
+// main thread submits. The queue is only a few frames deep, so simulation
+// runs at most that far ahead and frame N+1 is simulated while frame N is
+// submitted to GL. The framebuffer size travels with each frame, since the
+// resize callback runs on the main thread where no context is current.
+// Render is any callable taking a const Frame&. Either side sleeps on a
+// condition variable rather than spinning while the queue is empty or full.
+template <typename Frame, typename Render, size_t Depth = 3>
+class RenderThread {
+public:
+	// The context must be current on the calling thread; it is handed over.
+	RenderThread(GLFWwindow* window, Render render)
+		: window(window), render(render), running(true)
+	{
+		glfwMakeContextCurrent(NULL);
+		thread = std::thread(&RenderThread::run, this);
+	}
+
+	// Drains the queue and returns the context to the calling thread.
+	~RenderThread() {
+		running.store(false, std::memory_order_release);
+		notify(ready);
+		thread.join();
+		glfwMakeContextCurrent(window);
+	}
+
+	// Main thread only. Waits while the render thread is a full queue behind.
+	void submit(const Frame& frame) {
+		Packet packet = { frame, 0, 0 };
+		glfwGetFramebufferSize(window, &packet.width, &packet.height);
+		if (!packets.push(packet)) {
+			std::unique_lock<std::mutex> lock(mutex);
+			space.wait(lock, [this]() { return !packets.full(); });
+			packets.push(packet);
+		}
+		notify(ready);
+	}
+
+private:
+	struct Packet {
+		Frame frame;
+		int width;
+		int height;
+	};
+
+	GLFWwindow* window;
+	Render render;
+	SpscQueue<Packet, Depth + 1> packets;
+	std::atomic<bool> running;
+	// Only for sleeping; the queue itself stays lock-free. Taking the mutex
+	// before notifying means a wakeup can't slip in between the other
+	// side's check and its wait.
+	std::mutex mutex;
+	std::condition_variable ready;
+	std::condition_variable space;
+	std::thread thread;
+
+	void notify(std::condition_variable& condition) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+		}
+		condition.notify_one();
+	}
+
+	void run() {
+		glfwMakeContextCurrent(window);
+
+		Packet packet;
+		int width = 0, height = 0;
+		for (;;) {
+			// Read before popping: once stopping is seen every frame has
+			// already been pushed, so an empty queue really is drained.
+			bool stopping = !running.load(std::memory_order_acquire);
+
+			if (packets.pop(packet)) {
+				if (packet.width != width || packet.height != height) {
+					width = packet.width;
+					height = packet.height;
+					glViewport(0, 0, width, height);
+				}
+				notify(space);
+				PROFILE_ZONE("render");
+				render(packet.frame);
+				glfwSwapBuffers(window);
+			}
+			else if (stopping) {
+				break;
+			}
+			else {
+				std::unique_lock<std::mutex> lock(mutex);
+				ready.wait(lock, [this]() { return !packets.empty() || !running.load(std::memory_order_acquire); });
+			}
+		}
+
+		glFinish();
+		glfwMakeContextCurrent(NULL);
+	}
+};
+
+#endif // !RENDER_THREAD_H
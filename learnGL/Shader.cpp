@@ -1,4 +1,11 @@
 #include "Shader.h"
+#include "Extensions.h"
+#include "Profiler.h"
+
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <utility>
 
  std::string readShaderFile(const char* path) {
 	std::string code = "";
@@ -32,11 +39,31 @@ enum class ShaderError {
 	Linking,
 };
 
-void handleShaderError(unsigned id, ShaderError e) {
-	auto status = e == ShaderError::Linking ? GL_LINK_STATUS : GL_COMPILE_STATUS;
+// Returns the driver's full info log, which may hold warnings even when the
+// stage compiled or linked.
+std::string handleShaderError(unsigned id, ShaderError e) {
+	bool linking = e == ShaderError::Linking;
 
-	int success;
-	glGetProgramiv(id, status, &success);
+	int success, length;
+	if (linking) {
+		glGetProgramiv(id, GL_LINK_STATUS, &success);
+		glGetProgramiv(id, GL_INFO_LOG_LENGTH, &length);
+	}
+	else {
+		glGetShaderiv(id, GL_COMPILE_STATUS, &success);
+		glGetShaderiv(id, GL_INFO_LOG_LENGTH, &length);
+	}
+
+	std::string infoLog(length > 0 ? length : 1, '\0');
+	if (length > 0) {
+		if (linking) {
+			glGetProgramInfoLog(id, length, NULL, &infoLog[0]);
+		}
+		else {
+			glGetShaderInfoLog(id, length, NULL, &infoLog[0]);
+		}
+	}
+	infoLog.resize(std::strlen(infoLog.c_str()));
 
 	if (!success) {
 		const char* error = "";
@@ -54,8 +81,6 @@ void handleShaderError(unsigned id, ShaderError e) {
 		default:
 			break;
 		}
-		char infoLog[512];
-		glGetShaderInfoLog(id, 512, NULL, infoLog);
 		std::cout << "ERROR::SHADER::" << error << infoLog << std::endl;
 		/*
 		std::ofstream myfile;
@@ -64,57 +89,403 @@ void handleShaderError(unsigned id, ShaderError e) {
 		myfile.close();
 		*/
 	}
+
+	return infoLog;
 }
 
-unsigned compileShader(std::string code, ShaderType type) {
+unsigned compileShader(std::string code, ShaderType type, std::string& log) {
 	const char* c = code.c_str();
 	unsigned id = glCreateShader(GLenum(type));
 	glShaderSource(id, 1, &c, NULL);
 	glCompileShader(id);
 
-	handleShaderError(id, type == ShaderType::Vertex? ShaderError::Vertex: ShaderError::Fragment);
+	log += handleShaderError(id, type == ShaderType::Vertex? ShaderError::Vertex: ShaderError::Fragment);
 
 	return id;
 }
 
-unsigned linkShader(unsigned vertex, unsigned fragment) {
+unsigned linkShader(unsigned vertex, unsigned fragment, std::string& log) {
 	unsigned id = glCreateProgram();
 
 	glAttachShader(id, vertex);
 	glAttachShader(id, fragment);
 	glLinkProgram(id);
 
-	handleShaderError(id, ShaderError::Linking);
+	log += handleShaderError(id, ShaderError::Linking);
+
+	return id;
+}
+
+unsigned linkStage(unsigned shader, std::string& log) {
+	unsigned id = glCreateProgram();
+
+	glExtensions().programParameteri(id, GL_PROGRAM_SEPARABLE, GL_TRUE);
+	glAttachShader(id, shader);
+	glLinkProgram(id);
+	glDetachShader(id, shader);
+	glDeleteShader(shader);
+
+	log += handleShaderError(id, ShaderError::Linking);
+
+	return id;
+}
+
+unsigned createPipeline(unsigned vertex, unsigned fragment) {
+	auto& ext = glExtensions();
+	unsigned id;
+
+	ext.genProgramPipelines(1, &id);
+	ext.useProgramStages(id, GL_VERTEX_SHADER_BIT, vertex);
+	ext.useProgramStages(id, GL_FRAGMENT_SHADER_BIT, fragment);
 
 	return id;
 }
 
+// Each file is compiled once and each vertex/fragment pair linked once, so
+// N vertex and M fragment variants cost N + M compiles. With separable
+// programs the pair is only a pipeline object and nothing is re-linked.
+std::map<std::string, ShaderStageReport> stageCache;
+std::map<std::pair<unsigned, unsigned>, unsigned> programCache;
+
+// Shared by every Shader using the same program, so the shadow values always
+// match what GL actually holds.
+std::map<unsigned, std::map<std::string, Uniform>> uniformCache;
+
+std::vector<ShaderReport> shaderReports;
+
+// Only touched from the thread building shaders; the reads themselves run on
+// workers.
+std::map<std::string, std::shared_future<std::string>> prefetchedFiles;
+
+void prefetchShaderFile(const char* path) {
+	if (prefetchedFiles.count(path)) {
+		return;
+	}
+
+	std::string file = path;
+	prefetchedFiles[path] = std::async(std::launch::async, [file]() {
+		PROFILE_ZONE("shader read");
+		return readShaderFile(file.c_str());
+	}).share();
+}
+
+double elapsedMs(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+ShaderStageReport loadStage(const char* path, ShaderType type, bool separable) {
+	auto key = std::to_string(int(type)) + ":" + path;
+	auto found = stageCache.find(key);
+	if (found != stageCache.end()) {
+		auto stage = found->second;
+		stage.cached = true;
+		stage.readMs = stage.compileMs = stage.linkMs = 0;
+		return stage;
+	}
+
+	ShaderStageReport stage = { path, 0, false, 0, 0, 0 };
+
+	auto start = std::chrono::steady_clock::now();
+	std::string code;
+	auto prefetched = prefetchedFiles.find(path);
+	if (prefetched != prefetchedFiles.end()) {
+		// readMs is then only the time spent waiting for the worker.
+		PROFILE_ZONE("shader read wait");
+		code = prefetched->second.get();
+		prefetchedFiles.erase(prefetched);
+	}
+	else {
+		PROFILE_ZONE("shader read");
+		code = readShaderFile(path);
+	}
+	stage.readMs = elapsedMs(start);
+
+	// Compile time includes the status query, since drivers may defer the
+	// actual work until someone asks.
+	start = std::chrono::steady_clock::now();
+	{
+		PROFILE_ZONE("shader compile");
+		stage.id = compileShader(code, type, stage.log);
+	}
+	stage.compileMs = elapsedMs(start);
+
+	if (separable) {
+		PROFILE_ZONE("shader link");
+		start = std::chrono::steady_clock::now();
+		stage.id = linkStage(stage.id, stage.log);
+		stage.linkMs = elapsedMs(start);
+	}
+
+	stageCache[key] = stage;
+	return stage;
+}
+
 Shader::Shader(const char* vertexPath, const char* fragmentPath)
 {
-	auto vShaderCode = readShaderFile(vertexPath);
-	auto fShaderCode = readShaderFile(fragmentPath);
+	separable = glExtensions().separateShaderObjects;
 
-	auto vertex = compileShader(vShaderCode, ShaderType::Vertex);
-	auto fragment = compileShader(fShaderCode, ShaderType::Fragment);
-	ID = linkShader(vertex, fragment);
+	report = ShaderReport();
+	report.vertex = loadStage(vertexPath, ShaderType::Vertex, separable);
+	report.fragment = loadStage(fragmentPath, ShaderType::Fragment, separable);
+	vertexProgram = report.vertex.id;
+	fragmentProgram = report.fragment.id;
+
+	auto key = std::make_pair(vertexProgram, fragmentProgram);
+	auto found = programCache.find(key);
+	report.cached = found != programCache.end();
+	if (report.cached) {
+		ID = found->second;
+	}
+	else {
+		PROFILE_ZONE("shader link");
+		auto start = std::chrono::steady_clock::now();
+		ID = separable
+			? createPipeline(vertexProgram, fragmentProgram)
+			: linkShader(vertexProgram, fragmentProgram, report.log);
+		report.linkMs = elapsedMs(start);
+		programCache[key] = ID;
+	}
+
+	uniforms = &uniformCache[ID];
+	shaderReports.push_back(report);
+
+	std::cout << "Load Shader, " << vertexPath << " + " << fragmentPath << "\t" << report.totalMs() << "ms"
+		<< (report.cached ? " (cached)" : "") << std::endl;
 }
 
 void Shader::use()
 {
-	glUseProgram(ID);
+	if (separable) {
+		glUseProgram(0);
+		glExtensions().bindProgramPipeline(ID);
+	}
+	else {
+		glUseProgram(ID);
+	}
+
+	flush();
+}
+
+// Looks the uniform up once; with separable programs it belongs to whichever
+// stage declares it.
+Uniform& Shader::uniform(const std::string& name) const
+{
+	auto found = uniforms->find(name);
+	if (found != uniforms->end()) {
+		return found->second;
+	}
+
+	Uniform u = { -1, ID, GL_NONE, 0, false };
+	if (!separable) {
+		u.location = glGetUniformLocation(ID, name.c_str());
+	}
+	else {
+		for (unsigned program : { vertexProgram, fragmentProgram }) {
+			u.location = glGetUniformLocation(program, name.c_str());
+			if (u.location != -1) {
+				u.program = program;
+				break;
+			}
+		}
+	}
+
+	return (*uniforms)[name] = u;
+}
+
+void Shader::store(const std::string& name, GLenum type, const void* value, int count, size_t size) const
+{
+	auto& u = uniform(name);
+	if (u.location == -1) {
+		return;
+	}
+
+	if (u.type == type && u.count == count && u.value.size() == size &&
+		std::memcmp(u.value.data(), value, size) == 0) {
+		return;
+	}
+
+	auto bytes = static_cast<const char*>(value);
+	u.type = type;
+	u.count = count;
+	u.value.assign(bytes, bytes + size);
+	u.dirty = true;
+}
+
+void Shader::flush() const
+{
+	for (auto& entry : *uniforms) {
+		auto& u = entry.second;
+		if (!u.dirty) {
+			continue;
+		}
+
+		// With a pipeline bound, glUniform* writes to its active program.
+		if (separable) {
+			glExtensions().activeShaderProgram(ID, u.program);
+		}
+
+		auto f = reinterpret_cast<const float*>(u.value.data());
+		switch (u.type)
+		{
+		case GL_INT:
+			glUniform1iv(u.location, u.count, reinterpret_cast<const int*>(u.value.data()));
+			break;
+		case GL_FLOAT:
+			glUniform1fv(u.location, u.count, f);
+			break;
+		case GL_FLOAT_VEC2:
+			glUniform2fv(u.location, u.count, f);
+			break;
+		case GL_FLOAT_VEC3:
+			glUniform3fv(u.location, u.count, f);
+			break;
+		case GL_FLOAT_VEC4:
+			glUniform4fv(u.location, u.count, f);
+			break;
+		case GL_FLOAT_MAT3:
+			glUniformMatrix3fv(u.location, u.count, GL_FALSE, f);
+			break;
+		case GL_FLOAT_MAT4:
+			glUniformMatrix4fv(u.location, u.count, GL_FALSE, f);
+			break;
+		default:
+			break;
+		}
+
+		u.dirty = false;
+	}
 }
 
 void Shader::setBool(const std::string& name, bool value) const
 {
-	glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+	setInt(name, (int)value);
 }
 
 void Shader::setInt(const std::string& name, int value) const
 {
-	glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+	store(name, GL_INT, &value, 1, sizeof(value));
 }
 
 void Shader::setFloat(const std::string& name, float value) const
 {
-	glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
-}
\ No newline at end of file
+	store(name, GL_FLOAT, &value, 1, sizeof(value));
+}
+
+void Shader::setVec2(const std::string& name, float x, float y) const
+{
+	float value[] = { x, y };
+	setVec2(name, value);
+}
+
+void Shader::setVec3(const std::string& name, float x, float y, float z) const
+{
+	float value[] = { x, y, z };
+	setVec3(name, value);
+}
+
+void Shader::setVec4(const std::string& name, float x, float y, float z, float w) const
+{
+	float value[] = { x, y, z, w };
+	setVec4(name, value);
+}
+
+void Shader::setVec2(const std::string& name, const float* value, int count) const
+{
+	store(name, GL_FLOAT_VEC2, value, count, 2 * count * sizeof(float));
+}
+
+void Shader::setVec3(const std::string& name, const float* value, int count) const
+{
+	store(name, GL_FLOAT_VEC3, value, count, 3 * count * sizeof(float));
+}
+
+void Shader::setVec4(const std::string& name, const float* value, int count) const
+{
+	store(name, GL_FLOAT_VEC4, value, count, 4 * count * sizeof(float));
+}
+
+void Shader::setMat3(const std::string& name, const float* value, int count) const
+{
+	store(name, GL_FLOAT_MAT3, value, count, 9 * count * sizeof(float));
+}
+
+void Shader::setMat4(const std::string& name, const float* value, int count) const
+{
+	store(name, GL_FLOAT_MAT4, value, count, 16 * count * sizeof(float));
+}
+
+double ShaderReport::totalMs() const
+{
+	return vertex.readMs + vertex.compileMs + vertex.linkMs +
+		fragment.readMs + fragment.compileMs + fragment.linkMs + linkMs;
+}
+
+std::string escapeJson(const std::string& text) {
+	std::string out;
+	for (char c : text) {
+		switch (c)
+		{
+		case '"':
+			out += "\\\"";
+			break;
+		case '\\':
+			out += "\\\\";
+			break;
+		case '\n':
+			out += "\\n";
+			break;
+		case '\r':
+			out += "\\r";
+			break;
+		case '\t':
+			out += "\\t";
+			break;
+		default:
+			// Any other control character, e.g. ESC from a colored driver log.
+			if (static_cast<unsigned char>(c) < 0x20) {
+				const char* hex = "0123456789abcdef";
+				out += "\\u00";
+				out += hex[(c >> 4) & 0xF];
+				out += hex[c & 0xF];
+			}
+			else {
+				out += c;
+			}
+			break;
+		}
+	}
+	return out;
+}
+
+void writeStageReport(std::ostream& out, const ShaderStageReport& stage) {
+	out << "{ \"path\": \"" << escapeJson(stage.path) << "\""
+		<< ", \"cached\": " << (stage.cached ? "true" : "false")
+		<< ", \"readMs\": " << stage.readMs
+		<< ", \"compileMs\": " << stage.compileMs
+		<< ", \"linkMs\": " << stage.linkMs
+		<< ", \"log\": \"" << escapeJson(stage.log) << "\" }";
+}
+
+void writeShaderReports(const char* path)
+{
+	std::ofstream out(path);
+	if (!out) {
+		std::cout << "ERROR::SHADER::REPORT_NOT_WRITTEN: " << path << std::endl;
+		return;
+	}
+
+	out << "[\n";
+	for (size_t i = 0; i < shaderReports.size(); i++) {
+		auto& report = shaderReports[i];
+		out << "  {\n    \"vertex\": ";
+		writeStageReport(out, report.vertex);
+		out << ",\n    \"fragment\": ";
+		writeStageReport(out, report.fragment);
+		out << ",\n    \"cached\": " << (report.cached ? "true" : "false")
+			<< ",\n    \"linkMs\": " << report.linkMs
+			<< ",\n    \"totalMs\": " << report.totalMs()
+			<< ",\n    \"log\": \"" << escapeJson(report.log) << "\"\n  }"
+			<< (i + 1 < shaderReports.size() ? "," : "") << "\n";
+	}
+	out << "]\n";
+}
@@ -1,100 +1,733 @@
 
+#include <algorithm>
 #include <iostream>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <vector>
 #include "shader.h"
 #include "Window.h"
+#include "Input.h"
 #include "Image.h"
+#include "CommandBuffer.h"
+#include "GpuProfiler.h"
+#include "Profiler.h"
+#include "Capture.h"
+#include "Startup.h"
+#include "Uploader.h"
+#include "DynamicResolution.h"
+#include "VertexLayout.h"
+#include "Quantize.h"
+#include "MeshOptimizer.h"
+#include "InstancedQuads.h"
+#include "SpriteBatch.h"
+#include "GpuHeap.h"
+#include "GeometryPool.h"
+#include "MeshImport.h"
 
-int main() {
-	GLFWwindow* win = initWindow();
+// The sprites' simulation rate, independent of the frame rate.
+const double SPRITE_STEP = 1.0 / 120;
+
+struct Options {
+	bool headless = false;
+	bool threaded = false;
+	const char* gpuCsv = NULL;
+	const char* trace = NULL;
+	int frames = 100;
+	const char* capture = NULL;
+	double fps = 0;
+	const char* captureGl = NULL;
+	int captureFrames = 10;
+	double dynamicMs = 0;
+	bool onChange = false;
+	bool floatVertices = false;
+	int benchInstances = 0;
+	int benchMeshes = 0;
+	int sprites = 0;
+	const char* mesh = NULL;
+};
+
+// --headless [--frames N] [--capture out.ppm] | [--threaded] [--fps N]
+// [--gpu-csv out.csv] [--trace out.json] [--capture-gl out.bin [--capture-frames N]]
+// [--dynamic-res targetMs] [--on-change] [--float-vertices] [--sprites N] [--mesh model.obj|.gltf|.glb]
+// | --bench-instancing N [--frames N] | --bench-multidraw N [--frames N]
+Options parseOptions(int argc, char** argv) {
+	Options options;
+
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+
+		if (arg == "--headless") {
+			options.headless = true;
+		}
+		else if (arg == "--threaded") {
+			options.threaded = true;
+		}
+		else if (arg == "--frames" && hasValue) {
+			options.frames = std::atoi(argv[++i]);
+		}
+		else if (arg == "--capture" && hasValue) {
+			options.capture = argv[++i];
+		}
+		else if (arg == "--fps" && hasValue) {
+			options.fps = std::atof(argv[++i]);
+		}
+		else if (arg == "--gpu-csv" && hasValue) {
+			options.gpuCsv = argv[++i];
+		}
+		else if (arg == "--trace" && hasValue) {
+			options.trace = argv[++i];
+		}
+		else if (arg == "--capture-gl" && hasValue) {
+			options.captureGl = argv[++i];
+		}
+		else if (arg == "--capture-frames" && hasValue) {
+			options.captureFrames = std::atoi(argv[++i]);
+		}
+		else if (arg == "--dynamic-res" && hasValue) {
+			options.dynamicMs = std::atof(argv[++i]);
+		}
+		else if (arg == "--on-change") {
+			options.onChange = true;
+		}
+		else if (arg == "--float-vertices") {
+			options.floatVertices = true;
+		}
+		else if (arg == "--sprites" && hasValue) {
+			options.sprites = std::atoi(argv[++i]);
+		}
+		else if (arg == "--mesh" && hasValue) {
+			options.mesh = argv[++i];
+		}
+		else if (arg == "--bench-instancing" && hasValue) {
+			options.benchInstances = std::atoi(argv[++i]);
+		}
+		else if (arg == "--bench-multidraw" && hasValue) {
+			options.benchMeshes = std::atoi(argv[++i]);
+		}
+		else {
+			std::cout << "Unknown option, " << arg << std::endl;
+		}
+	}
+
+	return options;
+}
+
+struct QuadVertex {
+	float position[3];
+	float color[3];
+	float uv[2];
+
+	static constexpr std::array<VertexAttribute, 3> layout() {
+		return { {
+			VERTEX_ATTRIBUTE(QuadVertex, position, 0),
+			VERTEX_ATTRIBUTE(QuadVertex, color, 1),
+			VERTEX_ATTRIBUTE(QuadVertex, uv, 2),
+		} };
+	}
+};
+
+// Half of QuadVertex's 32 bytes. Positions come back through the shader's
+// positionScale/positionOffset, color and uv as normalized integers.
+struct PackedQuadVertex {
+	Unorm16 position[3];
+	uint16_t padding;
+	Unorm8 color[4];
+	Unorm16 uv[2];
+
+	static constexpr std::array<VertexAttribute, 3> layout() {
+		return { {
+			VERTEX_ATTRIBUTE(PackedQuadVertex, position, 0),
+			VERTEX_ATTRIBUTE(PackedQuadVertex, color, 1),
+			VERTEX_ATTRIBUTE(PackedQuadVertex, uv, 2),
+		} };
+	}
+};
+
+PackedQuadVertex pack(const QuadVertex& vertex, const PositionQuantization& quantization) {
+	PackedQuadVertex packed = {};
+	quantizePosition(quantization, vertex.position, packed.position);
+	for (int i = 0; i < 3; i++) {
+		packed.color[i] = toUnorm8(vertex.color[i]);
+	}
+	packed.color[3] = toUnorm8(1);
+	for (int i = 0; i < 2; i++) {
+		packed.uv[i] = toUnorm16(vertex.uv[i]);
+	}
+	return packed;
+}
+
+// Replaces the quad with a model, centred and scaled to fill most of the
+// view, its normals shown as the vertex colors. Leaves the quad on failure.
+void loadMesh(const char* path, std::vector<QuadVertex>& vertices, std::vector<unsigned>& indices) {
+	ImportedMesh mesh;
+	if (!importMesh(path, mesh) || mesh.indices.empty()) {
+		return;
+	}
+
+	float low[3], high[3];
+	for (int c = 0; c < 3; c++) {
+		low[c] = high[c] = mesh.vertices[0].position[c];
+	}
+	for (auto& v : mesh.vertices) {
+		for (int c = 0; c < 3; c++) {
+			low[c] = std::min(low[c], v.position[c]);
+			high[c] = std::max(high[c], v.position[c]);
+		}
+	}
+	float extent = std::max(std::max(high[0] - low[0], high[1] - low[1]), high[2] - low[2]);
+	float scale = extent > 0 ? 1.8f / extent : 1;
+
+	vertices.resize(mesh.vertices.size());
+	for (size_t i = 0; i < mesh.vertices.size(); i++) {
+		auto& from = mesh.vertices[i];
+		for (int c = 0; c < 3; c++) {
+			vertices[i].position[c] = (from.position[c] - (low[c] + high[c]) / 2) * scale;
+			vertices[i].color[c] = from.normal[c] * 0.5f + 0.5f;
+		}
+		vertices[i].uv[0] = from.uv[0];
+		vertices[i].uv[1] = from.uv[1];
+	}
+	indices = std::move(mesh.indices);
+}
+
+// The profiler's summary on one line for the title bar, the one place on
+// screen that needs no text rendering, e.g. "LearnGL | clear: 0.012ms | ...".
+std::string gpuTimesTitle(const GpuProfiler& profiler) {
+	std::istringstream lines(profiler.summary());
+	std::string title = "LearnGL";
+	std::string line;
+	while (std::getline(lines, line)) {
+		title += " | " + line;
+	}
+	return title;
+}
+
+void run(GLFWwindow* win, const Options& options, Startup& startup) {
+
+	if (options.captureGl) {
+		beginCapture(options.captureGl, options.captureFrames);
+	}
 
 	Shader ourShader("shader.vs", "shader.fs");
+	writeShaderReports("shader_report.json");
 
 	//  d - a
 	//  |   |
 	//  c - b	
 
-	float vertices[] = {
-		// pos           // color       // texture
-		 0.5,  0.5, 0.0, 1.0, 0.0, 0.0, 1.0, 1.0, // a
-		 0.5, -0.5, 0.0, 0.0, 1.0, 0.0, 1.0, 0.0, // b
-		-0.5, -0.5, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, // c
-		-0.5,  0.5, 0.0, 1.0, 1.0, 0.0, 0.0, 1.0  // d
+	std::vector<QuadVertex> vertices = {
+		//  pos                  color              texture
+		{ {  0.5,  0.5, 0.0 }, { 1.0, 0.0, 0.0 }, { 1.0, 1.0 } }, // a
+		{ {  0.5, -0.5, 0.0 }, { 0.0, 1.0, 0.0 }, { 1.0, 0.0 } }, // b
+		{ { -0.5, -0.5, 0.0 }, { 0.0, 0.0, 1.0 }, { 0.0, 0.0 } }, // c
+		{ { -0.5,  0.5, 0.0 }, { 1.0, 1.0, 0.0 }, { 0.0, 1.0 } }, // d
 	};
 
-	unsigned indices[] = {
+	std::vector<unsigned> indices = {
 		0, 1, 3,
 		1, 2, 3,
 	};
 
-	GLuint VBO, VAO, EBO;
-	glGenVertexArrays(1, &VAO);
-	glGenBuffers(1, &VBO);
-	glGenBuffers(1, &EBO);
+	if (options.mesh) {
+		loadMesh(options.mesh, vertices, indices);
+	}
+
+	size_t vertexCount = vertices.size();
+	auto indexData = optimizeMesh(vertices.data(), vertexCount, sizeof(QuadVertex), indices.data(), indices.size());
+	vertices.resize(vertexCount);
 
+	// Vertices and indices are both ranges of one arena buffer.
+	GpuHeap heap(1 << 20);
+	GLuint VAO;
+	glGenVertexArrays(1, &VAO);
 	glBindVertexArray(VAO);
 
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+	PositionQuantization quantization = { { 1, 1, 1 }, { 0, 0, 0 } };
+	GpuAllocation vertexRange;
+	// Imported models keep float vertices: their uvs may tile past [0, 1] or
+	// come out negative from glTF's flip, which Unorm16 would clamp.
+	if (options.floatVertices || options.mesh) {
+		vertexRange = heap.allocate(vertexCount * sizeof(QuadVertex));
+		heap.write(vertexRange, vertices.data(), vertexCount * sizeof(QuadVertex));
+		glBindBuffer(GL_ARRAY_BUFFER, vertexRange.buffer);
+		setVertexLayout<QuadVertex>(vertexRange.offset);
+	}
+	else {
+		quantization = positionQuantization(vertices[0].position, vertexCount, sizeof(QuadVertex) / sizeof(float));
+		std::vector<PackedQuadVertex> packed(vertexCount);
+		for (size_t i = 0; i < vertexCount; i++) {
+			packed[i] = pack(vertices[i], quantization);
+		}
+		vertexRange = heap.allocate(vertexCount * sizeof(PackedQuadVertex));
+		heap.write(vertexRange, packed.data(), vertexCount * sizeof(PackedQuadVertex));
+		glBindBuffer(GL_ARRAY_BUFFER, vertexRange.buffer);
+		setVertexLayout<PackedQuadVertex>(vertexRange.offset);
+	}
+
+	auto indexRange = heap.allocate(indexData.bytes.size());
+	heap.write(indexRange, indexData.bytes.data(), indexData.bytes.size());
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexRange.buffer);
+
+	ourShader.setInt("texture1", 0);
+	ourShader.setInt("texture2", 1);
+	ourShader.setVec3("positionScale", quantization.scale);
+	ourShader.setVec3("positionOffset", quantization.offset);
+	ourShader.use();
+
+	// The scene never changes, so it is recorded once and replayed, and
+	// recorded again as each texture arrives from the loader.
+	GLuint textures[] = { 0, 0 };
+	CommandBuffer commands;
+	GLenum indexType = indexData.type;
+	size_t indexOffset = indexRange.offset;
+	GLsizei indexCount = GLsizei(indices.size());
+	auto record = [&commands, &textures, &ourShader, VAO, indexType, indexOffset, indexCount]() {
+		commands.clear();
+		commands.bindTextures(0, textures, 2);
+		commands.bindShader(ourShader);
+		commands.bindVertexArray(VAO);
+		commands.drawElements(GL_TRIANGLES, indexCount, indexType, indexOffset);
+	};
+	record();
+
+	// Decodes are joined on the loader too, so the quad is drawn untextured
+	// until both are in rather than holding up the first frame.
+	Uploader uploader(win);
+	const char* images[] = { "container.jpg", "awesomeface.png" };
+	for (int unit = 0; unit < 2; unit++) {
+		auto texture = std::make_shared<GLuint>(0);
+		auto path = images[unit];
+
+		uploader.submit([texture, path, &startup]() {
+			glGenTextures(1, texture.get());
+			glBindTexture(GL_TEXTURE_2D, *texture);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			bindImage(startup.takeImage(path), [](Image im) {
+				glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, im.width, im.height, 0, GL_RGB, GL_UNSIGNED_BYTE, im.data);
+				glGenerateMipmap(GL_TEXTURE_2D);
+			});
+		}, [texture, unit, &textures, &record]() {
+			textures[unit] = *texture;
+			record();
+			requestRedraw();
+		});
+	}
+
+	GpuProfiler profiler;
+	if (options.gpuCsv) {
+		profiler.logCsv(options.gpuCsv);
+	}
+
+	// Renders the scene at whatever scale keeps its GPU time under target.
+	std::unique_ptr<DynamicResolution> dynamic;
+	if (options.dynamicMs > 0) {
+		dynamic.reset(new DynamicResolution(options.dynamicMs));
+	}
+
+	// Sprites bouncing around the viewport over the quad, streamed fresh
+	// every frame. They move at a fixed step and are drawn alpha of the way
+	// from their previous position to the current one.
+	struct Bouncer {
+		Interpolated<float> x, y;
+		float vx, vy, size;
+		GLuint* texture;
+	};
+	std::vector<Bouncer> bouncers(options.sprites);
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> unit(0, 1);
+	for (auto& b : bouncers) {
+		float x = unit(random), y = unit(random);
+		b = Bouncer{ { x, x }, { y, y }, unit(random) - 0.5f, unit(random) - 0.5f,
+			8 + unit(random) * 24, &textures[random() % 2] };
+	}
+
+	std::unique_ptr<SpriteBatch> batch;
+	if (options.sprites > 0) {
+		// The ring streams straight into the heap when it is persistent.
+		batch.reset(new SpriteBatch(65536, &heap));
+	}
+
+	auto stepSprites = [&bouncers](double dt) {
+		for (auto& b : bouncers) {
+			b.x.set(b.x.current + b.vx * float(dt));
+			b.y.set(b.y.current + b.vy * float(dt));
+			b.vx = b.x.current < 0 || b.x.current > 1 ? -b.vx : b.vx;
+			b.vy = b.y.current < 0 || b.y.current > 1 ? -b.vy : b.vy;
+		}
+	};
+
+	double spriteAlpha = 1;
+	// Where the cursor sprite goes, as a fraction of the window; negative
+	// when there is none.
+	double pointerX = -1, pointerY = -1;
+	auto drawSprites = [&bouncers, &batch, &spriteAlpha, &textures, &pointerX, &pointerY]() {
+		GLint viewport[4];
+		glGetIntegerv(GL_VIEWPORT, viewport);
 
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+		batch->begin(viewport[2], viewport[3]);
+		for (auto& b : bouncers) {
+			batch->draw(*b.texture, b.x.at(spriteAlpha) * viewport[2], b.y.at(spriteAlpha) * viewport[3], b.size, b.size);
+		}
+		if (pointerX >= 0) {
+			batch->draw(textures[1], float(pointerX * viewport[2]) - 16, float(pointerY * viewport[3]) - 16, 32, 32);
+		}
+		batch->end();
+	};
+
+	// Frames between title bar updates, about a second at 60Hz. GLFW only
+	// sets the title from the main thread, so with --threaded the render
+	// thread leaves it in title for the simulate step to pick up.
+	const unsigned TITLE_INTERVAL = 60;
+	unsigned framesShown = 0;
+	std::mutex titleMutex;
+	std::string title;
+
+	auto frame = [win, &options, &commands, &profiler, &startup, &uploader, &dynamic, &batch, &drawSprites, &heap,
+		&framesShown, &titleMutex, &title]() {
+		uploader.poll();
+		// poll() only runs inside a frame, so with --on-change keep frames
+		// coming until every upload has landed and been drawn.
+		if (!uploader.idle()) {
+			requestRedraw();
+		}
+		heap.retire();
+		profiler.beginFrame();
+		{
+			GpuScope scene(profiler, "scene");
+			if (dynamic) {
+				dynamic->begin();
+			}
+			{
+				GpuScope scope(profiler, "clear");
+				glClearColor(0.2, 0.3, 0.3, 1.0);
+				glClear(GL_COLOR_BUFFER_BIT);
+			}
+			{
+				GpuScope scope(profiler, "quad");
+				commands.execute();
+			}
+			if (batch) {
+				GpuScope scope(profiler, "sprites");
+				drawSprites();
+			}
+			if (dynamic) {
+				dynamic->end();
+			}
+		}
+		profiler.endFrame();
+		if (dynamic) {
+			dynamic->update(profiler.average("scene"));
+		}
+		if (++framesShown % TITLE_INTERVAL == 0) {
+			if (options.threaded) {
+				std::lock_guard<std::mutex> lock(titleMutex);
+				title = gpuTimesTitle(profiler);
+			}
+			else {
+				glfwSetWindowTitle(win, gpuTimesTitle(profiler).c_str());
+			}
+		}
+		captureFrame();
+		startup.frameDone();
+	};
+
+	if (options.headless) {
+		// Benchmarks and captures should see the finished scene.
+		while (!uploader.idle()) {
+			uploader.poll();
+			std::this_thread::yield();
+		}
+		auto target = createRenderTarget(SCR_WIDTH, SCR_HEIGHT);
+		// A fixed step per frame, so captures and benchmarks repeat exactly.
+		auto step = [&stepSprites, &frame]() {
+			stepSprites(SPRITE_STEP);
+			frame();
+		};
+		whileHeadless(win, target, options.frames, step, options.capture);
+	}
+	else {
+		setVSync(VSync::On);
+		FramePacer pacer(options.fps);
+
+		if (options.threaded) {
+			// Nothing to simulate yet, the frame only carries the time step
+			// and the sprites move by it on the render thread.
+			auto render = [&stepSprites, &frame](const double& dt) {
+				stepSprites(dt);
+				frame();
+			};
+			auto simulate = [win, &titleMutex, &title](double dt) {
+				std::lock_guard<std::mutex> lock(titleMutex);
+				if (!title.empty()) {
+					glfwSetWindowTitle(win, title.c_str());
+					title.clear();
+				}
+				return dt;
+			};
+			whileOpenThreaded<double>(win, simulate, render, &pacer);
+		}
+		else if (batch) {
+			// The sprites always animate, so --on-change has nothing to skip.
+			// Space pauses them and a left click turns them all around, each
+			// applied at the step it happened in; a sprite follows the cursor,
+			// read just before rendering so it doesn't trail behind.
+			Input input;
+			input.attach(win);
+			bool paused = false;
+
+			auto update = [&input, &paused, &bouncers, &stepSprites](double dt, double time) {
+				input.consume(time, [&paused, &bouncers](const InputEvent& event) {
+					if (event.action != GLFW_PRESS) {
+						return;
+					}
+					if (event.type == InputType::Key && event.code == GLFW_KEY_SPACE) {
+						paused = !paused;
+					}
+					else if (event.type == InputType::MouseButton && event.code == GLFW_MOUSE_BUTTON_LEFT) {
+						for (auto& b : bouncers) {
+							b.vx = -b.vx;
+							b.vy = -b.vy;
+						}
+					}
+				});
+				stepSprites(paused ? 0 : dt);
+			};
+			auto render = [win, &input, &spriteAlpha, &pointerX, &pointerY, &frame](double alpha) {
+				int width, height;
+				glfwGetWindowSize(win, &width, &height);
+				double x, y;
+				input.cursor(x, y);
+				pointerX = width > 0 ? x / width : -1;
+				pointerY = height > 0 ? y / height : -1;
+
+				spriteAlpha = alpha;
+				frame();
+			};
+			whileOpen(win, SPRITE_STEP, update, render, &pacer);
+
+			if (input.dropped()) {
+				std::cout << "Input, " << input.dropped() << " events dropped" << std::endl;
+			}
+		}
+		else {
+			// The quad is static, so with --on-change nothing is drawn
+			// between resizes, key presses and finished uploads.
+			whileOpen(win, frame, &pacer, options.onChange ? Present::OnChange : Present::Always);
+		}
+
+		auto stats = pacer.stats();
+		std::cout << "Frames, " << stats.frames << "\t" << stats.meanMs << "ms avg, "
+			<< stats.stdDevMs << "ms stddev, " << stats.minMs << "-" << stats.maxMs << "ms" << std::endl;
+	}
+
+	std::cout << "GPU\n" << profiler.summary();
+	if (dynamic) {
+		std::cout << "Dynamic resolution, scale " << dynamic->scale() << std::endl;
+	}
+	if (batch) {
+		std::cout << "Sprites, " << bouncers.size() << " in " << batch->draws() << " draws, "
+			<< batch->orphans() << " orphans, " << batch->stalls() << " stalls last frame" << std::endl;
+	}
+	if (options.trace) {
+		writeTrace(options.trace);
+	}
+
+	glDeleteVertexArrays(1, &VAO);
+	glDeleteTextures(2, textures);
+
+	endCapture();
+}
+
+// Images of the same size as the layers of one array texture.
+GLuint createTextureArray(const char* const* paths, int count) {
+	GLuint texture;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	int width = 0, height = 0;
+	for (int layer = 0; layer < count; layer++) {
+		Image im = decodeImage(paths[layer]);
+		if (im.data && width == 0) {
+			width = im.width;
+			height = im.height;
+			glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, width, height, count, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+		}
+
+		if (im.data && im.width == width && im.height == height) {
+			GLenum format = im.nrChannels == 4 ? GL_RGBA : GL_RGB;
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, width, height, 1, format, GL_UNSIGNED_BYTE, im.data);
+			std::cout << "Load Image, " << im.path << "\t" << width << "x" << height << ", layer " << layer << std::endl;
+		}
+		else {
+			std::cout << "Failed to load texture layer, " << paths[layer] << std::endl;
+		}
+		stbi_image_free(im.data);
+	}
+
+	glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+	return texture;
+}
+
+// Times draw() over options.frames frames, waiting for the GPU after each,
+// and prints the CPU submit time and the whole frame time.
+void measureDraws(const Options& options, const char* name, std::function<void()> draw) {
+	FrameClock clock;
+	double submit = 0, total = 0;
+	// One frame untimed, so first-use costs don't count.
+	for (int i = 0; i <= options.frames; i++) {
+		glClear(GL_COLOR_BUFFER_BIT);
+		glFinish();
+		clock.tick();
+		draw();
+		double cpu = clock.tick();
+		glFinish();
+		double gpu = clock.tick();
+		if (i > 0) {
+			submit += cpu;
+			total += cpu + gpu;
+		}
+	}
+
+	int frames = options.frames > 0 ? options.frames : 1;
+	std::cout << name << "\t" << submit * 1000 / frames << "ms submit, "
+		<< total * 1000 / frames << "ms frame" << std::endl;
+}
 
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8*sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
+// Draws the same random quads as one instanced draw and as one draw each,
+// offscreen, and prints the CPU submit and full frame times of both.
+void benchmarkInstancing(const Options& options) {
+	Shader shader("instanced.vs", "instanced.fs");
+	const char* layers[] = { "container.jpg", "awesomeface.png" };
+	GLuint textureArray = createTextureArray(layers, 2);
+	shader.setInt("textures", 0);
+	shader.use();
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, textureArray);
 
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3*sizeof(float)));
-	glEnableVertexAttribArray(1);
+	std::vector<QuadInstance> instances(options.benchInstances);
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> unit(0, 1);
+	for (auto& q : instances) {
+		q.offset[0] = unit(random) * 2 - 1;
+		q.offset[1] = unit(random) * 2 - 1;
+		q.scale[0] = q.scale[1] = 0.01f + unit(random) * 0.03f;
+		q.rotation = unit(random) * 6.2831853f;
+		for (auto& channel : q.tint) {
+			channel = toUnorm8(0.5f + unit(random) * 0.5f);
+		}
+		q.layer = random() % 2;
+	}
 
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6*sizeof(float)));
-	glEnableVertexAttribArray(2);
+	InstancedQuads quads;
+	quads.set(instances.data(), instances.size());
 
-	GLuint texture1, texture2;
+	auto target = createRenderTarget(SCR_WIDTH, SCR_HEIGHT);
+	glBindFramebuffer(GL_FRAMEBUFFER, target.framebuffer);
+	glViewport(0, 0, target.width, target.height);
 
-	glGenTextures(1, &texture1);
-	glBindTexture(GL_TEXTURE_2D, texture1);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	std::cout << "Instancing, " << instances.size() << " quads, " << options.frames << " frames" << std::endl;
+	measureDraws(options, "1 instanced draw", [&quads]() { quads.draw(); });
+	measureDraws(options, "separate draws", [&quads, &instances]() { quads.drawSeparately(instances.data(), instances.size()); });
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	deleteRenderTarget(target);
+	glDeleteTextures(1, &textureArray);
+}
+
+// Many small meshes packed into one GeometryPool, drawn one call each and
+// then as a single multi-draw.
+void benchmarkMultiDraw(const Options& options) {
+	Shader shader("sprite.vs", "sprite.fs");
+	shader.setInt("sprite", 0);
+	shader.use();
+	GLuint texture;
+	glGenTextures(1, &texture);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, texture);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 	bindImage("container.jpg", [](Image im) {
 		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, im.width, im.height, 0, GL_RGB, GL_UNSIGNED_BYTE, im.data);
-		glGenerateMipmap(GL_TEXTURE_2D);
 	});
 
-	glGenTextures(1, &texture2);
-	glBindTexture(GL_TEXTURE_2D, texture2);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	bindImage("awesomeface.png", [](Image im) {
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, im.width, im.height, 0, GL_RGB, GL_UNSIGNED_BYTE, im.data);
-		glGenerateMipmap(GL_TEXTURE_2D);
-	});
+	size_t count = size_t(options.benchMeshes);
+	GpuHeap heap;
+	GeometryPool<SpriteVertex> pool(heap, count * 4, count * 6);
+	std::vector<PooledMesh> meshes(count);
 
-	ourShader.use();
-	glUniform1i(glGetUniformLocation(ourShader.ID, "texture1"), 0);
-	// ourShader.setInt("texture2", 1);
-	glUniform1i(glGetUniformLocation(ourShader.ID, "texture2"), 1);
-
-	auto a = [texture1]() {};
-	
-	whileOpen(win, [texture1, texture2, &ourShader, VAO]() {
-		glClearColor(0.2, 0.3, 0.3, 1.0);
-		glClear(GL_COLOR_BUFFER_BIT);
+	// Quads in clip space; the indices are the same for each, as they are
+	// relative to the mesh's own vertices.
+	const uint32_t indices[] = { 0, 1, 3, 1, 2, 3 };
+	const float corners[4][2] = { { 1, 1 }, { 1, -1 }, { -1, -1 }, { -1, 1 } };
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> unit(0, 1);
+	for (auto& mesh : meshes) {
+		float x = unit(random) * 2 - 1, y = unit(random) * 2 - 1, size = 0.01f + unit(random) * 0.03f;
+		SpriteVertex quad[4];
+		for (int i = 0; i < 4; i++) {
+			quad[i].position[0] = x + corners[i][0] * size;
+			quad[i].position[1] = y + corners[i][1] * size;
+			quad[i].uv[0] = corners[i][0] * 0.5f + 0.5f;
+			quad[i].uv[1] = corners[i][1] * 0.5f + 0.5f;
+			for (auto& channel : quad[i].color) {
+				channel = toUnorm8(1);
+			}
+		}
+		pool.add(quad, 4, indices, 6, mesh);
+	}
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, texture1);
+	GeometryDrawList layer;
+	layer.set(pool, meshes.data(), meshes.size());
 
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, texture2);
+	auto target = createRenderTarget(SCR_WIDTH, SCR_HEIGHT);
+	glBindFramebuffer(GL_FRAMEBUFFER, target.framebuffer);
+	glViewport(0, 0, target.width, target.height);
 
-		ourShader.use();
-		glBindVertexArray(VAO);
-		glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+	std::cout << "Multi-draw, " << count << " meshes, " << options.frames << " frames" << std::endl;
+	measureDraws(options, "separate draws", [&pool, &meshes]() {
+		glBindVertexArray(pool.vertexArray());
+		for (auto& mesh : meshes) {
+			auto offset = (void*)((pool.indexBase() + size_t(mesh.firstIndex)) * sizeof(uint32_t));
+			glDrawElementsBaseVertex(GL_TRIANGLES, mesh.count, GL_UNSIGNED_INT, offset, mesh.baseVertex);
+		}
 	});
+	measureDraws(options, "1 multi-draw", [&pool, &meshes]() { pool.draw(meshes.data(), meshes.size()); });
+	measureDraws(options, layer.indirect() ? "1 indirect draw list" : "1 draw list", [&layer]() { layer.draw(); });
 
-	glDeleteVertexArrays(1, &VAO);
-	glDeleteBuffers(1, &VBO);
-	glDeleteBuffers(1, &EBO);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	deleteRenderTarget(target);
+	glDeleteTextures(1, &texture);
+}
+
+int main(int argc, char** argv) {
+	// Nothing on disk needs a context, so reads start before the window.
+	Startup startup;
+	startup.shader("shader.vs", "shader.fs");
+	startup.image("container.jpg");
+	startup.image("awesomeface.png");
+
+	auto options = parseOptions(argc, argv);
+	GLFWwindow* win = initWindow(options.headless);
+	startup.windowReady();
+
+	if (options.benchInstances > 0) {
+		benchmarkInstancing(options);
+	}
+	else if (options.benchMeshes > 0) {
+		benchmarkMultiDraw(options);
+	}
+	else {
+		run(win, options, startup);
+	}
+
+	glfwTerminate();
+	return 0;
 }
@@ -0,0 +1,252 @@
+#include "SpriteBatch.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cstring>
+
+// Quads per draw at most, so 16-bit indices can address every vertex.
+const size_t MAX_BATCH = 16384;
+
+SpriteBatch::SpriteBatch(size_t capacity, GpuHeap* heap)
+	: shader("sprite.vs", "sprite.fs"), heap(heap), ring{ 0, 0, 0, NULL, -1 }, capacity(capacity), cursor(0),
+	width(1), height(1), sort(SpriteSort::Texture), drawCount(0), orphanCount(0), stallCount(0)
+{
+	for (auto& fence : fences) {
+		fence = NULL;
+	}
+
+	// Every batch reuses the same 0 1 2, 2 3 0 pattern; the offset into the
+	// ring is passed as the base vertex.
+	std::vector<uint16_t> indices(MAX_BATCH * 6);
+	for (size_t i = 0; i < MAX_BATCH; i++) {
+		uint16_t v = uint16_t(i * 4);
+		uint16_t quad[] = { v, uint16_t(v + 1), uint16_t(v + 2), uint16_t(v + 2), uint16_t(v + 3), v };
+		std::copy(quad, quad + 6, &indices[i * 6]);
+	}
+
+	glGenVertexArrays(1, &vertexArray);
+	glBindVertexArray(vertexArray);
+
+	glGenBuffers(1, &indexBuffer);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint16_t), indices.data(), GL_STATIC_DRAW);
+
+	if (heap && heap->persistent()) {
+		ring = heap->allocate(capacity * sizeof(Sprite::vertices));
+	}
+	if (ring.data) {
+		vertexBuffer = ring.buffer;
+		glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+		setVertexLayout<SpriteVertex>(ring.offset);
+	}
+	else {
+		glGenBuffers(1, &vertexBuffer);
+		glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+		glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(Sprite::vertices), NULL, GL_STREAM_DRAW);
+		setVertexLayout<SpriteVertex>();
+	}
+
+	glBindVertexArray(0);
+	shader.setInt("sprite", 0);
+}
+
+SpriteBatch::~SpriteBatch()
+{
+	for (int region = 0; region < REGIONS; region++) {
+		releaseFence(region);
+	}
+	glDeleteVertexArrays(1, &vertexArray);
+	if (ring.data) {
+		heap->free(ring);
+	}
+	else {
+		glDeleteBuffers(1, &vertexBuffer);
+	}
+	glDeleteBuffers(1, &indexBuffer);
+}
+
+void SpriteBatch::begin(int width, int height, SpriteSort sort)
+{
+	this->width = width;
+	this->height = height;
+	this->sort = sort;
+	sprites.clear();
+	drawCount = 0;
+	orphanCount = 0;
+	stallCount = 0;
+}
+
+void SpriteBatch::draw(GLuint texture, float x, float y, float w, float h, const float uv[4], const Unorm8 color[4])
+{
+	const float fullUv[] = { 0, 0, 1, 1 };
+	const Unorm8 white[] = { { 255 }, { 255 }, { 255 }, { 255 } };
+	uv = uv ? uv : fullUv;
+	color = color ? color : white;
+
+	// Pixels, y down, to clip space.
+	float left = x / width * 2 - 1, right = (x + w) / width * 2 - 1;
+	float top = 1 - y / height * 2, bottom = 1 - (y + h) / height * 2;
+
+	const Unorm8 c0 = color[0], c1 = color[1], c2 = color[2], c3 = color[3];
+	Sprite sprite = { texture, {
+		{ { left, top }, { uv[0], uv[3] }, { c0, c1, c2, c3 } },
+		{ { left, bottom }, { uv[0], uv[1] }, { c0, c1, c2, c3 } },
+		{ { right, bottom }, { uv[2], uv[1] }, { c0, c1, c2, c3 } },
+		{ { right, top }, { uv[2], uv[3] }, { c0, c1, c2, c3 } },
+	} };
+	sprites.push_back(sprite);
+}
+
+void SpriteBatch::end()
+{
+	PROFILE_ZONE("sprite batch");
+	if (sprites.empty()) {
+		return;
+	}
+
+	order.resize(sprites.size());
+	for (uint32_t i = 0; i < order.size(); i++) {
+		order[i] = i;
+	}
+	if (sort == SpriteSort::Texture) {
+		std::stable_sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+			return sprites[a].texture < sprites[b].texture;
+		});
+	}
+
+	shader.use();
+	glActiveTexture(GL_TEXTURE0);
+	glBindVertexArray(vertexArray);
+	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+
+	// As many sprites as fit before the end of the ring go in one map, or
+	// straight into the heap's mapping.
+	size_t done = 0;
+	while (done < order.size()) {
+		size_t count = std::min(order.size() - done, capacity);
+		size_t first = reserve(count);
+
+		char* bytes = ring.data ? ring.data + first * sizeof(Sprite::vertices) : static_cast<char*>(glMapBufferRange(GL_ARRAY_BUFFER,
+			first * sizeof(Sprite::vertices), count * sizeof(Sprite::vertices),
+			GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT));
+		for (size_t i = 0; i < count; i++) {
+			std::memcpy(bytes + i * sizeof(Sprite::vertices), sprites[order[done + i]].vertices, sizeof(Sprite::vertices));
+		}
+		if (!ring.data) {
+			glUnmapBuffer(GL_ARRAY_BUFFER);
+		}
+
+		// One draw per run of a texture, split at the index buffer's size.
+		size_t run = 0;
+		while (run < count) {
+			GLuint texture = sprites[order[done + run]].texture;
+			size_t length = 1;
+			while (run + length < count && length < MAX_BATCH && sprites[order[done + run + length]].texture == texture) {
+				length++;
+			}
+
+			glBindTexture(GL_TEXTURE_2D, texture);
+			glDrawElementsBaseVertex(GL_TRIANGLES, GLsizei(length * 6), GL_UNSIGNED_SHORT, 0, GLint((first + run) * 4));
+			drawCount++;
+			run += length;
+		}
+
+		fence(first, first + count);
+		cursor = first + count;
+		done += count;
+	}
+
+	glBindVertexArray(0);
+}
+
+unsigned SpriteBatch::draws() const
+{
+	return drawCount;
+}
+
+unsigned SpriteBatch::orphans() const
+{
+	return orphanCount;
+}
+
+unsigned SpriteBatch::stalls() const
+{
+	return stallCount;
+}
+
+// Finds room for count sprites, wrapping to the start of the ring when they
+// don't fit before the end, and makes sure the GPU is done with every
+// region they land in. Returns the first sprite slot.
+size_t SpriteBatch::reserve(size_t count)
+{
+	size_t first = cursor + count <= capacity ? cursor : 0;
+	size_t regionSize = (capacity + REGIONS - 1) / REGIONS;
+
+	// Appending within the region last written is safe without a check:
+	// those slots were cleared when the ring entered it on this lap.
+	int current = first == cursor && cursor > 0 ? int((cursor - 1) / regionSize) : -1;
+
+	for (int region = int(first / regionSize); region <= int((first + count - 1) / regionSize); region++) {
+		if (region == current || !fences[region]) {
+			continue;
+		}
+
+		GLenum status = glClientWaitSync(fences[region], 0, 0);
+		if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED) {
+			releaseFence(region);
+		}
+		else if (ring.data) {
+			// The heap's storage can't be orphaned, so wait it out, for a
+			// second at most.
+			glClientWaitSync(fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+			releaseFence(region);
+			stallCount++;
+		}
+		else {
+			// Still being read; fresh storage beats waiting for it.
+			orphan();
+			return 0;
+		}
+	}
+
+	return first;
+}
+
+// One fence covers every region the slots [first, last) touched.
+void SpriteBatch::fence(size_t first, size_t last)
+{
+	size_t regionSize = (capacity + REGIONS - 1) / REGIONS;
+	GLsync sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+	for (int region = int(first / regionSize); region <= int((last - 1) / regionSize); region++) {
+		releaseFence(region);
+		fences[region] = sync;
+	}
+}
+
+// Fences are shared between regions, so only the last holder deletes one.
+void SpriteBatch::releaseFence(int region)
+{
+	GLsync sync = fences[region];
+	if (!sync) {
+		return;
+	}
+
+	fences[region] = NULL;
+	for (auto other : fences) {
+		if (other == sync) {
+			return;
+		}
+	}
+	glDeleteSync(sync);
+}
+
+void SpriteBatch::orphan()
+{
+	glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(Sprite::vertices), NULL, GL_STREAM_DRAW);
+	for (int region = 0; region < REGIONS; region++) {
+		releaseFence(region);
+	}
+	cursor = 0;
+	orphanCount++;
+}
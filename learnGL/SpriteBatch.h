@@ -0,0 +1,99 @@
+#ifndef SPRITE_BATCH_H
+#define SPRITE_BATCH_H
+
+#include <glad/glad.h>
+#include "shader.h"
+#include "GpuHeap.h"
+#include "VertexLayout.h"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+struct SpriteVertex {
+	float position[2];
+	float uv[2];
+	Unorm8 color[4];
+
+	static constexpr std::array<VertexAttribute, 3> layout() {
+		return { {
+			VERTEX_ATTRIBUTE(SpriteVertex, position, 0),
+			VERTEX_ATTRIBUTE(SpriteVertex, uv, 2),
+			VERTEX_ATTRIBUTE(SpriteVertex, color, 6),
+		} };
+	}
+};
+
+enum class SpriteSort {
+	// Fewest draws; sprites with different textures may reorder.
+	Texture,
+	// Keeps painter's order, merging only neighbours with one texture.
+	Submission,
+};
+
+// Collects sprites between begin() and end(), then writes them into one
+// big streaming VBO and draws each run of a texture with a single call.
+//
+// The VBO is a ring split into regions. Writes go straight into it through
+// unsynchronized maps, and each end() fences the regions it wrote. Before
+// the ring comes round to a region again its fence is checked without
+// waiting; if the GPU is still reading it, the whole buffer is orphaned
+// instead, so the CPU never stalls on the GPU.
+//
+// Given a GpuHeap with persistent arenas, the ring is a range of one of
+// them instead and sprites are memcpy'd straight in with no map calls. That
+// memory can't be orphaned, so a region the GPU is still reading is waited
+// for; with several regions of the ring in between this should be rare.
+class SpriteBatch {
+public:
+	// Ring size in sprites; a frame with more is drawn in several passes.
+	// The heap, if any, must outlive the batch.
+	SpriteBatch(size_t capacity = 65536, GpuHeap* heap = NULL);
+	~SpriteBatch();
+
+	// Sprites are in pixels from the top left of a width x height viewport.
+	void begin(int width, int height, SpriteSort sort = SpriteSort::Texture);
+	void draw(GLuint texture, float x, float y, float width, float height,
+		const float uv[4] = NULL, const Unorm8 color[4] = NULL);
+	void end();
+
+	// For the last end(): draw calls issued, and how often the ring had to
+	// be orphaned, or in a heap waited on, because the GPU was behind.
+	unsigned draws() const;
+	unsigned orphans() const;
+	unsigned stalls() const;
+
+private:
+	struct Sprite {
+		GLuint texture;
+		SpriteVertex vertices[4];
+	};
+
+	static const int REGIONS = 4;
+
+	Shader shader;
+	GLuint vertexArray;
+	GLuint vertexBuffer;
+	GLuint indexBuffer;
+	GpuHeap* heap;
+	// Empty unless the ring lives in the heap.
+	GpuAllocation ring;
+	size_t capacity;
+	size_t cursor;
+	GLsync fences[REGIONS];
+	std::vector<Sprite> sprites;
+	std::vector<uint32_t> order;
+	int width;
+	int height;
+	SpriteSort sort;
+	unsigned drawCount;
+	unsigned orphanCount;
+	unsigned stallCount;
+
+	size_t reserve(size_t count);
+	void fence(size_t first, size_t last);
+	void releaseFence(int region);
+	void orphan();
+};
+
+#endif // !SPRITE_BATCH_H
@@ -0,0 +1,82 @@
+#ifndef STARTUP_H
+#define STARTUP_H
+
+#include "shader.h"
+#include "Image.h"
+#include "Profiler.h"
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <map>
+#include <string>
+
+// Starts shader reads and image decodes on workers as soon as the app
+// launches, so they overlap window creation and GL loading instead of
+// queueing behind them. Each asset is joined where GL first needs it, and
+// cold start comes down to the longest of the two chains.
+class Startup {
+public:
+	Startup() : start(std::chrono::steady_clock::now()), windowMs(0), waitMs(0), reported(false) {}
+
+	~Startup() {
+		for (auto& image : images) {
+			stbi_image_free(image.second.get().data);
+		}
+	}
+
+	void shader(const char* vertexPath, const char* fragmentPath) {
+		prefetchShaderFile(vertexPath);
+		prefetchShaderFile(fragmentPath);
+	}
+
+	void image(const char* path) {
+		if (!images.count(path)) {
+			images[path] = std::async(std::launch::async, decodeImage, path);
+		}
+	}
+
+	// Waits for the decode started by image(path), or decodes it here if it
+	// never was. The caller owns the data, e.g. through bindImage.
+	Image takeImage(const char* path) {
+		auto found = images.find(path);
+		if (found == images.end()) {
+			return decodeImage(path);
+		}
+
+		PROFILE_ZONE("image decode wait");
+		auto waitStart = std::chrono::steady_clock::now();
+		Image im = found->second.get();
+		images.erase(found);
+		waitMs += msSince(waitStart);
+		return im;
+	}
+
+	// Call once the context is current and GL is loaded.
+	void windowReady() {
+		windowMs = msSince(start);
+	}
+
+	// Call at the end of every frame; reports time-to-first-frame once.
+	void frameDone() {
+		if (reported) {
+			return;
+		}
+
+		reported = true;
+		std::cout << "Startup, window " << windowMs << "ms, waited on assets " << waitMs
+			<< "ms, first frame " << msSince(start) << "ms" << std::endl;
+	}
+
+private:
+	std::chrono::steady_clock::time_point start;
+	double windowMs;
+	double waitMs;
+	bool reported;
+	std::map<std::string, std::future<Image>> images;
+
+	static double msSince(std::chrono::steady_clock::time_point from) {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - from).count();
+	}
+};
+
+#endif // !STARTUP_H
@@ -0,0 +1,132 @@
+#include "Uploader.h"
+#include "Capture.h"
+#include "Profiler.h"
+
+#include <iostream>
+
+Uploader::Uploader(GLFWwindow* window) : loader(NULL), busy(0), running(true)
+{
+	// The capture file is written from one thread, so uploads stay on it.
+	if (capturing()) {
+		return;
+	}
+
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	loader = glfwCreateWindow(1, 1, "Loader", NULL, window);
+	if (loader == NULL) {
+		std::cout << "Loader context failed, uploading inline" << std::endl;
+		return;
+	}
+
+	thread = std::thread(&Uploader::run, this);
+}
+
+Uploader::~Uploader()
+{
+	if (loader == NULL) {
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		running = false;
+	}
+	wake.notify_one();
+	thread.join();
+
+	// Sync objects are shared, so the fences can go from here.
+	for (auto& job : uploaded) {
+		glDeleteSync(job.fence);
+	}
+	glfwDestroyWindow(loader);
+}
+
+void Uploader::submit(std::function<void()> upload, std::function<void()> ready)
+{
+	if (loader == NULL) {
+		upload();
+		ready();
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		queued.push_back(Job{ upload, ready, NULL });
+		busy++;
+	}
+	wake.notify_one();
+}
+
+int Uploader::poll()
+{
+	std::vector<Job> done;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (uploaded.empty()) {
+			return 0;
+		}
+
+		// Fences signal in submission order, so stop at the first that hasn't.
+		size_t signalled = 0;
+		for (auto& job : uploaded) {
+			GLint status = GL_UNSIGNALED;
+			glGetSynciv(job.fence, GL_SYNC_STATUS, 1, NULL, &status);
+			if (status != GL_SIGNALED) {
+				break;
+			}
+			signalled++;
+		}
+
+		done.assign(uploaded.begin(), uploaded.begin() + signalled);
+		uploaded.erase(uploaded.begin(), uploaded.begin() + signalled);
+		busy -= signalled;
+	}
+
+	for (auto& job : done) {
+		// Already signalled, so this costs nothing; it is what makes the
+		// loader's writes visible to this context's command stream.
+		glWaitSync(job.fence, 0, GL_TIMEOUT_IGNORED);
+		glDeleteSync(job.fence);
+		job.ready();
+	}
+
+	return int(done.size());
+}
+
+bool Uploader::idle()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return busy == 0;
+}
+
+void Uploader::run()
+{
+	glfwMakeContextCurrent(loader);
+
+	for (;;) {
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [this]() { return !running || !queued.empty(); });
+			if (!running) {
+				break;
+			}
+			job = queued.front();
+			queued.pop_front();
+		}
+
+		{
+			PROFILE_ZONE("upload");
+			job.upload();
+		}
+
+		// Flush so the fence reaches the GPU; nothing waits on it here.
+		job.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		glFlush();
+
+		std::lock_guard<std::mutex> lock(mutex);
+		uploaded.push_back(job);
+	}
+
+	glfwMakeContextCurrent(NULL);
+}
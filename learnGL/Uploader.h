@@ -0,0 +1,53 @@
+#ifndef UPLOADER_H
+#define UPLOADER_H
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Creates and fills GL objects on a loader thread with its own context,
+// shared with the window's, so big uploads don't stall the frame. Each job
+// is fenced when it finishes; poll() hands it to the render thread once the
+// fence has signalled, never blocking the CPU or the GPU on the way.
+class Uploader {
+public:
+	// Main thread only, like every GLFW window call. Without a shared
+	// context, e.g. while capturing, jobs run inline on the submitting thread.
+	Uploader(GLFWwindow* window);
+	~Uploader();
+
+	// upload runs with the loader context current and returns nothing GL
+	// needs to keep; ready then runs on the thread calling poll().
+	void submit(std::function<void()> upload, std::function<void()> ready);
+
+	// Render thread, once per frame. Returns how many jobs became ready.
+	int poll();
+
+	bool idle();
+
+private:
+	struct Job {
+		std::function<void()> upload;
+		std::function<void()> ready;
+		GLsync fence;
+	};
+
+	GLFWwindow* loader;
+	std::thread thread;
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::deque<Job> queued;
+	std::vector<Job> uploaded;
+	size_t busy;
+	bool running;
+
+	void run();
+};
+
+#endif // !UPLOADER_H
@@ -0,0 +1,135 @@
+#ifndef VERTEX_LAYOUT_H
+#define VERTEX_LAYOUT_H
+
+#include <glad/glad.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// A vertex struct lists its attributes once, in a static constexpr layout(),
+// and setVertexLayout turns that into the attribute pointer calls for the
+// bound VAO. Strides, offsets and GL types all come from the struct itself:
+//
+//	struct Vertex {
+//		float position[3];
+//		Unorm8 color[4];
+//
+//		static constexpr std::array<VertexAttribute, 2> layout() {
+//			return { {
+//				VERTEX_ATTRIBUTE(Vertex, position, 0),
+//				VERTEX_ATTRIBUTE(Vertex, color, 1),
+//			} };
+//		}
+//	};
+//
+// A member of a type GL can't fetch, over four components, or overlapping
+// another fails to compile.
+
+// Integer components read as [0, 1] or [-1, 1] floats in the shader. Plain
+// integer members are passed through unconverted to int/uint inputs.
+struct Unorm8 { uint8_t value; };
+struct Snorm8 { int8_t value; };
+struct Unorm16 { uint16_t value; };
+struct Snorm16 { int16_t value; };
+// IEEE 754 binary16, see toHalf in Quantize.h.
+struct Half { uint16_t bits; };
+
+template <typename T>
+struct VertexComponent {
+	static_assert(sizeof(T) == 0, "GL can't fetch this vertex component type");
+};
+
+template <GLenum Type, bool Normalized, bool Integer>
+struct VertexComponentOf {
+	static constexpr GLenum type = Type;
+	static constexpr bool normalized = Normalized;
+	static constexpr bool integer = Integer;
+};
+
+template <> struct VertexComponent<float> : VertexComponentOf<GL_FLOAT, false, false> {};
+template <> struct VertexComponent<Half> : VertexComponentOf<GL_HALF_FLOAT, false, false> {};
+template <> struct VertexComponent<Unorm8> : VertexComponentOf<GL_UNSIGNED_BYTE, true, false> {};
+template <> struct VertexComponent<Snorm8> : VertexComponentOf<GL_BYTE, true, false> {};
+template <> struct VertexComponent<Unorm16> : VertexComponentOf<GL_UNSIGNED_SHORT, true, false> {};
+template <> struct VertexComponent<Snorm16> : VertexComponentOf<GL_SHORT, true, false> {};
+template <> struct VertexComponent<uint8_t> : VertexComponentOf<GL_UNSIGNED_BYTE, false, true> {};
+template <> struct VertexComponent<int8_t> : VertexComponentOf<GL_BYTE, false, true> {};
+template <> struct VertexComponent<uint16_t> : VertexComponentOf<GL_UNSIGNED_SHORT, false, true> {};
+template <> struct VertexComponent<int16_t> : VertexComponentOf<GL_SHORT, false, true> {};
+template <> struct VertexComponent<uint32_t> : VertexComponentOf<GL_UNSIGNED_INT, false, true> {};
+template <> struct VertexComponent<int32_t> : VertexComponentOf<GL_INT, false, true> {};
+
+struct VertexAttribute {
+	GLuint location;
+	GLint components;
+	GLenum type;
+	bool normalized;
+	bool integer;
+	size_t offset;
+	size_t size;
+};
+
+// Member is T or T[N]; use VERTEX_ATTRIBUTE rather than calling this.
+template <typename Member>
+constexpr VertexAttribute vertexAttribute(GLuint location, size_t offset) {
+	using Component = typename std::remove_all_extents<Member>::type;
+	using Traits = VertexComponent<Component>;
+	static_assert(std::rank<Member>::value <= 1, "vertex attributes are scalars or 1D arrays");
+	static_assert(sizeof(Member) / sizeof(Component) <= 4, "vertex attributes have at most 4 components");
+
+	return VertexAttribute{
+		location,
+		GLint(sizeof(Member) / sizeof(Component)),
+		Traits::type,
+		Traits::normalized,
+		Traits::integer,
+		offset,
+		sizeof(Member),
+	};
+}
+
+#define VERTEX_ATTRIBUTE(Vertex, member, location) \
+	vertexAttribute<decltype(Vertex::member)>(location, offsetof(Vertex, member))
+
+// Every attribute inside the vertex, none overlapping, no location twice.
+template <size_t N>
+constexpr bool validLayout(const std::array<VertexAttribute, N>& attributes, size_t stride) {
+	for (size_t i = 0; i < N; i++) {
+		if (attributes[i].offset + attributes[i].size > stride) {
+			return false;
+		}
+		for (size_t j = i + 1; j < N; j++) {
+			auto& a = attributes[i];
+			auto& b = attributes[j];
+			if (a.location == b.location ||
+				(a.offset < b.offset + b.size && b.offset < a.offset + a.size)) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+// Points the bound VAO's attributes at the buffer bound to GL_ARRAY_BUFFER,
+// starting at byte offset base. A nonzero divisor makes them per-instance.
+template <typename Vertex>
+void setVertexLayout(size_t base = 0, GLuint divisor = 0) {
+	static_assert(std::is_standard_layout<Vertex>::value, "vertex structs need a standard layout for offsetof");
+	static_assert(validLayout(Vertex::layout(), sizeof(Vertex)), "vertex attributes overlap, overrun the struct or share a location");
+
+	for (auto& a : Vertex::layout()) {
+		auto pointer = (void*)(base + a.offset);
+		if (a.integer) {
+			glVertexAttribIPointer(a.location, a.components, a.type, sizeof(Vertex), pointer);
+		}
+		else {
+			glVertexAttribPointer(a.location, a.components, a.type, a.normalized, sizeof(Vertex), pointer);
+		}
+		glEnableVertexAttribArray(a.location);
+		glVertexAttribDivisor(a.location, divisor);
+	}
+}
+
+#endif // !VERTEX_LAYOUT_H
@@ -3,21 +3,97 @@
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include "RenderTarget.h"
+#include "FramePacer.h"
+#include "RenderThread.h"
+#include "Profiler.h"
 #include <iostream>
+#include <atomic>
+#include <chrono>
 #include <functional>
 
 const unsigned SCR_WIDTH = 800;
 const unsigned SCR_HEIGHT = 600;
 
+// A drag-resize reports many sizes per frame; only the latest is kept and
+// applied once at the next frame boundary.
+struct PendingResize {
+	int width;
+	int height;
+	bool pending;
+};
+
+PendingResize pendingResize = { 0, 0, false };
+
+// Called with the new framebuffer size after the viewport is updated, e.g.
+// to resize render targets.
+std::function<void(int, int)> onResize;
+
+// Set by anything that changes what a frame would show; whileOpen with
+// Present::OnChange only renders when it is.
+std::atomic<bool> redrawRequested(true);
+
+// Safe from any thread; wakes a loop blocked waiting for events.
+void requestRedraw() {
+	redrawRequested.store(true);
+	glfwPostEmptyEvent();
+}
+
 void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
-	glViewport(0, 0, width, height);
+	pendingResize = PendingResize{ width, height, true };
+	redrawRequested.store(true);
+}
+
+// A minimized window reports 0x0; that size is held back until it returns.
+void applyResize() {
+	if (!pendingResize.pending || pendingResize.width == 0 || pendingResize.height == 0) {
+		return;
+	}
+
+	pendingResize.pending = false;
+	glViewport(0, 0, pendingResize.width, pendingResize.height);
+
+	if (onResize) {
+		onResize(pendingResize.width, pendingResize.height);
+	}
+}
+
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+	if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
+		glfwSetWindowShouldClose(window, true);
+	redrawRequested.store(true);
+}
+
+// The window was uncovered or needs repainting for some other reason.
+void refresh_callback(GLFWwindow* window) {
+	redrawRequested.store(true);
 }
 
-GLFWwindow* initWindow() {
+void focus_callback(GLFWwindow* window, int focused) {
+	redrawRequested.store(true);
+}
+
+// Headless creates a hidden window whose context renders into a RenderTarget.
+// GLFW 3.4 can do this without any display through its null platform and
+// an EGL surfaceless context, which Mesa's llvmpipe supports.
+GLFWwindow* initWindow(bool headless = false) {
+#ifdef GLFW_PLATFORM_NULL
+	if (headless && glfwPlatformSupported(GLFW_PLATFORM_NULL)) {
+		glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+	}
+#endif
 	glfwInit();
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	if (headless) {
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+#ifdef GLFW_PLATFORM_NULL
+		if (glfwGetPlatform() == GLFW_PLATFORM_NULL) {
+			glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+		}
+#endif
+	}
 	GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "LearnGL", NULL, NULL);
 
 	if (window == NULL) {
@@ -34,27 +110,226 @@ GLFWwindow* initWindow() {
 
 	glViewport(0, 0, 800, 600);
 	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+	glfwSetKeyCallback(window, key_callback);
+	glfwSetWindowRefreshCallback(window, refresh_callback);
+	glfwSetWindowFocusCallback(window, focus_callback);
 
 	return window;
 }
 
-void processInput(GLFWwindow* window)
-{
-	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
-		glfwSetWindowShouldClose(window, true);
+// Monotonic high-resolution clock, in seconds.
+struct FrameClock {
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::chrono::steady_clock::time_point last = start;
+
+	double now() const {
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	// Time since the previous tick.
+	double tick() {
+		auto current = std::chrono::steady_clock::now();
+		double dt = std::chrono::duration<double>(current - last).count();
+		last = current;
+		return dt;
+	}
+};
+
+// Keeps the last two simulation states so rendering can blend between them.
+template <typename T>
+struct Interpolated {
+	T previous;
+	T current;
+
+	void set(const T& value) {
+		previous = current;
+		current = value;
+	}
+
+	T at(double alpha) const {
+		return previous + (current - previous) * alpha;
+	}
+};
+
+// How long a loop sleeps in glfwWaitEventsTimeout when there is nothing to
+// draw, or between frames while the window is in the background.
+const double IDLE_TIMEOUT = 0.1;
+
+enum class Present {
+	// Render every frame, e.g. for animation or benchmarks.
+	Always,
+	// Skip rendering and swapping until requestRedraw() or an event that
+	// changes the picture, for static scenes.
+	OnChange,
+};
+
+// A minimized window has nothing to draw into. Blocks for events and
+// returns true while that is the case.
+bool waitWhileMinimized(GLFWwindow* window) {
+	int width, height;
+	glfwGetFramebufferSize(window, &width, &height);
+	if (!glfwGetWindowAttrib(window, GLFW_ICONIFIED) && width > 0 && height > 0) {
+		return false;
+	}
+
+	PROFILE_ZONE("idle");
+	glfwWaitEventsTimeout(IDLE_TIMEOUT);
+	return true;
+}
+
+template <typename Render>
+void whileOpen(GLFWwindow* window, Render render, FramePacer* pacer = NULL, Present present = Present::Always) {
+	while (!glfwWindowShouldClose(window)) {
+		if (waitWhileMinimized(window)) {
+			continue;
+		}
+
+		// Cleared before rendering, so a request made meanwhile still counts.
+		if (!redrawRequested.exchange(false) && present == Present::OnChange) {
+			PROFILE_ZONE("idle");
+			glfwWaitEventsTimeout(IDLE_TIMEOUT);
+			continue;
+		}
+
+		PROFILE_ZONE("frame");
+		applyResize();
+		{
+			PROFILE_ZONE("render");
+			render();
+		}
+		{
+			PROFILE_ZONE("swap");
+			glfwSwapBuffers(window);
+		}
+
+		// In the background a few frames a second is plenty.
+		if (glfwGetWindowAttrib(window, GLFW_FOCUSED)) {
+			glfwPollEvents();
+		}
+		else {
+			glfwWaitEventsTimeout(IDLE_TIMEOUT);
+		}
+
+		if (pacer) {
+			pacer->wait();
+		}
+	}
+}
+
+// Renders a fixed number of frames into target, waiting for each to finish
+// on the GPU, prints frame times and optionally saves the last frame.
+template <typename Render>
+void whileHeadless(GLFWwindow* window, RenderTarget& target, int frames, Render render, const char* capturePath = NULL) {
+	FrameClock clock;
+	double total = 0, worst = 0;
+
+	glBindFramebuffer(GL_FRAMEBUFFER, target.framebuffer);
+	glViewport(0, 0, target.width, target.height);
+
+	for (int i = 0; i < frames; i++) {
+		clock.tick();
+
+		PROFILE_ZONE("frame");
+		render();
+		glFinish();
+
+		double frame = clock.tick();
+		total += frame;
+		worst = frame > worst ? frame : worst;
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	if (frames > 0) {
+		std::cout << "Headless, " << frames << " frames\t" << total * 1000 / frames << "ms avg, "
+			<< worst * 1000 << "ms worst" << std::endl;
+	}
+
+	if (capturePath) {
+		writeRenderTarget(target, capturePath);
+	}
+
+	deleteRenderTarget(target);
 }
 
-void whileOpen(GLFWwindow* window, std::function<void(void)> callback) {
+// Runs update(dt, time) at a fixed step however fast frames come, then
+// render(alpha) once per frame, alpha being how far the clock is between the
+// last update and the next. time is the glfwGetTime() a step ends at, for
+// Input::consume. Events are polled again just before rendering so the
+// latest input state is latched as late as possible.
+template <typename Update, typename Render>
+void whileOpen(GLFWwindow* window, double dt, Update update, Render render, FramePacer* pacer = NULL) {
+	FrameClock clock;
+	double accumulator = 0;
+
 	while (!glfwWindowShouldClose(window)) {
-		processInput(window);
+		// The simulation pauses while minimized rather than catching up after.
+		if (waitWhileMinimized(window)) {
+			clock.tick();
+			continue;
+		}
+
+		PROFILE_ZONE("frame");
+		glfwPollEvents();
 
-		callback();
+		// Cap the catch-up after a stall so it doesn't spiral.
+		double frame = clock.tick();
+		double now = glfwGetTime();
+		accumulator += frame < 0.25 ? frame : 0.25;
+
+		while (accumulator >= dt) {
+			PROFILE_ZONE("update");
+			accumulator -= dt;
+			update(dt, now - accumulator);
+		}
 
-		glfwSwapBuffers(window);
 		glfwPollEvents();
+		applyResize();
+		{
+			PROFILE_ZONE("render");
+			render(accumulator / dt);
+		}
+		{
+			PROFILE_ZONE("swap");
+			glfwSwapBuffers(window);
+		}
+
+		// In the background a few frames a second is plenty. Like being
+		// minimized, the wait is dropped from the clock rather than caught up.
+		if (!glfwGetWindowAttrib(window, GLFW_FOCUSED)) {
+			glfwWaitEventsTimeout(IDLE_TIMEOUT);
+			clock.tick();
+		}
+
+		if (pacer) {
+			pacer->wait();
+		}
 	}
+}
 
-	glfwTerminate();
+// Polls events and runs simulate(dt) on this thread while a RenderThread
+// draws the Frame it returns, e.g. whileOpenThreaded<State>(window, ...).
+template <typename Frame, typename Simulate, typename Render>
+void whileOpenThreaded(GLFWwindow* window, Simulate simulate, Render render, FramePacer* pacer = NULL) {
+	glfwSetFramebufferSizeCallback(window, NULL);
+	{
+		RenderThread<Frame, Render> renderer(window, render);
+		FrameClock clock;
+
+		while (!glfwWindowShouldClose(window)) {
+			PROFILE_ZONE("frame");
+			{
+				PROFILE_ZONE("simulate");
+				renderer.submit(simulate(clock.tick()));
+			}
+
+			glfwPollEvents();
+
+			if (pacer) {
+				pacer->wait();
+			}
+		}
+	}
 }
 
 #endif // !WINDOW_H
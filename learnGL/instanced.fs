@@ -0,0 +1,13 @@
+#version 330 core
+
+out vec4 FragColor;
+
+in vec2 TexCoord;
+in vec4 Tint;
+flat in uint Layer;
+
+uniform sampler2DArray textures;
+
+void main() {
+	FragColor = texture(textures, vec3(TexCoord, float(Layer))) * Tint;
+}
@@ -0,0 +1,25 @@
+#version 330 core
+
+layout (location = 0) in vec2 aPos;
+layout (location = 2) in vec2 aTexCoord;
+
+// Per instance, see QuadInstance.
+layout (location = 3) in vec2 aOffset;
+layout (location = 4) in vec2 aScale;
+layout (location = 5) in float aRotation;
+layout (location = 6) in vec4 aTint;
+layout (location = 7) in uint aLayer;
+
+out vec2 TexCoord;
+out vec4 Tint;
+flat out uint Layer;
+
+void main() {
+	float s = sin(aRotation);
+	float c = cos(aRotation);
+	vec2 p = aPos * aScale;
+	gl_Position = vec4(aOffset + vec2(c * p.x - s * p.y, s * p.x + c * p.y), 0.0, 1.0);
+	TexCoord = aTexCoord;
+	Tint = aTint;
+	Layer = aLayer;
+}
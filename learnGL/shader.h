@@ -7,15 +7,75 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <map>
+#include <vector>
+
+// Shadow copy of one uniform; only sent to GL when its value changed.
+struct Uniform {
+	int location;
+	unsigned program;
+	GLenum type;
+	int count;
+	bool dirty;
+	std::vector<char> value;
+};
+
+// Build timings in milliseconds. Cached stages and programs report zero.
+struct ShaderStageReport {
+	std::string path;
+	unsigned id;
+	bool cached;
+	double readMs;
+	double compileMs;
+	double linkMs;
+	std::string log;
+};
+
+struct ShaderReport {
+	ShaderStageReport vertex;
+	ShaderStageReport fragment;
+	bool cached;
+	double linkMs;
+	std::string log;
+	double totalMs() const;
+};
 
 class Shader {
 public:
+	// program, or program pipeline when separable
 	unsigned ID;
+	bool separable;
+	ShaderReport report;
 	Shader(const char* vertexPath, const char* fragmentPath);
 	void use();
+	// Setters only update the shadow values; changed ones are uploaded on
+	// the next use() or flush(). Vectors and matrices take column-major
+	// floats, count elements of an array uniform.
 	void setBool(const std::string& name, bool value) const;
 	void setInt(const std::string& name, int value) const;
 	void setFloat(const std::string& name, float value) const;
+	void setVec2(const std::string& name, float x, float y) const;
+	void setVec3(const std::string& name, float x, float y, float z) const;
+	void setVec4(const std::string& name, float x, float y, float z, float w) const;
+	void setVec2(const std::string& name, const float* value, int count = 1) const;
+	void setVec3(const std::string& name, const float* value, int count = 1) const;
+	void setVec4(const std::string& name, const float* value, int count = 1) const;
+	void setMat3(const std::string& name, const float* value, int count = 1) const;
+	void setMat4(const std::string& name, const float* value, int count = 1) const;
+	void flush() const;
+private:
+	unsigned vertexProgram;
+	unsigned fragmentProgram;
+	std::map<std::string, Uniform>* uniforms;
+	Uniform& uniform(const std::string& name) const;
+	void store(const std::string& name, GLenum type, const void* value, int count, size_t size) const;
 };
 
+// Starts reading a shader file on a worker thread; the Shader built from it
+// later picks the text up instead of reading it again.
+void prefetchShaderFile(const char* path);
+
+// Writes the reports of every Shader built so far as JSON.
+void writeShaderReports(const char* path);
+
 #endif // !SHADER_H
@@ -7,8 +7,12 @@ layout (location = 2) in vec2 aTexCoord;
 out vec3 ourColor;
 out vec2 TexCoord;
 
+// Undoes position quantization; 1 and 0 for float positions.
+uniform vec3 positionScale;
+uniform vec3 positionOffset;
+
 void main() {
-	gl_Position = vec4(aPos, 1.0);
+	gl_Position = vec4(aPos * positionScale + positionOffset, 1.0);
 	ourColor = aColor;
 	TexCoord = aTexCoord;
 }
\ No newline at end of file
@@ -0,0 +1,14 @@
+#version 330 core
+
+layout (location = 0) in vec2 aPos;
+layout (location = 2) in vec2 aTexCoord;
+layout (location = 6) in vec4 aTint;
+
+out vec2 TexCoord;
+out vec4 Tint;
+
+void main() {
+	gl_Position = vec4(aPos, 0.0, 1.0);
+	TexCoord = aTexCoord;
+	Tint = aTint;
+}
@@ -0,0 +1,599 @@
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#include "Window.h"
+#include "CaptureFormat.h"
+
+// Thrown when a record runs past the end of the capture or its data is
+// smaller than the call it belongs to reads, before that call is made.
+struct TruncatedCapture {};
+
+// Re-issues a capture written by learnGL --capture-gl, timing every frame.
+// Names and uniform locations are mapped to whatever this context hands out.
+class Replayer {
+public:
+	Replayer(const std::vector<char>& data) : data(data), cursor(0), program(0), unpackAlignment(4) {}
+
+	bool readHeader() {
+		return data.size() >= 8 && read<uint32_t>() == CAPTURE_MAGIC && read<uint32_t>() == CAPTURE_VERSION;
+	}
+
+	size_t position() const {
+		return cursor;
+	}
+
+	void seek(size_t position) {
+		cursor = position;
+	}
+
+	bool done() const {
+		return cursor >= data.size();
+	}
+
+	// Runs calls up to and including the next frame marker. Returns false
+	// at the end of the capture, on an unknown call or on a truncated one.
+	bool runFrame() {
+		size_t start = cursor;
+		try {
+			while (!done()) {
+				start = cursor;
+				auto op = read<CaptureOp>();
+				if (op == CaptureOp::Frame) {
+					return true;
+				}
+				if (!run(op)) {
+					std::cout << "Unknown call " << int(op) << " at " << start << std::endl;
+					cursor = data.size();
+					return false;
+				}
+			}
+		}
+		catch (const TruncatedCapture&) {
+			std::cout << "Truncated capture, call at " << start << std::endl;
+			cursor = data.size();
+		}
+		return false;
+	}
+
+private:
+	const std::vector<char>& data;
+	size_t cursor;
+	GLuint program;
+	GLint unpackAlignment;
+
+	std::map<GLuint, GLuint> textures, buffers, vertexArrays, programs, framebuffers, renderbuffers;
+	std::map<std::pair<GLuint, GLint>, GLint> locations;
+
+	template <typename T>
+	T read() {
+		if (data.size() - cursor < sizeof(T)) {
+			throw TruncatedCapture();
+		}
+		T value;
+		std::memcpy(&value, &data[cursor], sizeof(T));
+		cursor += sizeof(T);
+		return value;
+	}
+
+	// Returns the blob in place; it stays valid as long as the data does.
+	// Only for bytes, as it may sit at any alignment.
+	const char* blob(uint64_t& size) {
+		size = read<uint64_t>();
+		if (data.size() - cursor < size) {
+			throw TruncatedCapture();
+		}
+		const char* bytes = size ? &data[cursor] : NULL;
+		cursor += size;
+		return bytes;
+	}
+
+	// A blob the call reads expected bytes of, or NULL if none was stored.
+	const char* blob(uint64_t expected, bool optional) {
+		uint64_t size;
+		const char* bytes = blob(size);
+		if (size < expected && !(optional && size == 0)) {
+			throw TruncatedCapture();
+		}
+		return bytes;
+	}
+
+	// A blob of count values, copied out so they are properly aligned.
+	template <typename T>
+	std::vector<T> array(int64_t count) {
+		if (count < 0) {
+			throw TruncatedCapture();
+		}
+		std::vector<T> values(static_cast<size_t>(count));
+		const char* bytes = blob(uint64_t(count) * sizeof(T), false);
+		if (count > 0) {
+			std::memcpy(values.data(), bytes, values.size() * sizeof(T));
+		}
+		return values;
+	}
+
+	const char* pixels(GLsizei w, GLsizei h, GLenum format, GLenum type) {
+		if (w < 0 || h < 0) {
+			throw TruncatedCapture();
+		}
+		return blob(imageSize(w, h, format, type, unpackAlignment), true);
+	}
+
+	static GLuint map(std::map<GLuint, GLuint>& names, GLuint name) {
+		auto found = names.find(name);
+		return found != names.end() ? found->second : name;
+	}
+
+	GLint location(GLint captured) {
+		auto found = locations.find(std::make_pair(program, captured));
+		return found != locations.end() ? found->second : captured;
+	}
+
+	template <typename Gen>
+	void generate(std::map<GLuint, GLuint>& names, Gen gen) {
+		auto n = read<GLsizei>();
+		auto captured = array<GLuint>(n);
+		std::vector<GLuint> created(n);
+		gen(n, created.data());
+		for (GLsizei i = 0; i < n; i++) {
+			names[captured[i]] = created[i];
+		}
+	}
+
+	template <typename Delete>
+	void destroy(std::map<GLuint, GLuint>& names, Delete del) {
+		auto n = read<GLsizei>();
+		auto captured = array<GLuint>(n);
+		std::vector<GLuint> mapped(n);
+		for (GLsizei i = 0; i < n; i++) {
+			mapped[i] = map(names, captured[i]);
+			names.erase(captured[i]);
+		}
+		del(n, mapped.data());
+	}
+
+	static const void* pointer(uint64_t offset) {
+		return (const void*)uintptr_t(offset);
+	}
+
+	bool run(CaptureOp op) {
+		switch (op)
+		{
+		case CaptureOp::Clear:
+			glClear(read<GLbitfield>());
+			break;
+		case CaptureOp::ClearColor: {
+			auto r = read<GLfloat>(); auto g = read<GLfloat>(); auto b = read<GLfloat>(); auto a = read<GLfloat>();
+			glClearColor(r, g, b, a);
+			break;
+		}
+		case CaptureOp::Viewport: {
+			auto x = read<GLint>(); auto y = read<GLint>(); auto w = read<GLsizei>(); auto h = read<GLsizei>();
+			glViewport(x, y, w, h);
+			break;
+		}
+		case CaptureOp::Enable:
+			glEnable(read<GLenum>());
+			break;
+		case CaptureOp::Disable:
+			glDisable(read<GLenum>());
+			break;
+		case CaptureOp::BlendFunc: {
+			auto source = read<GLenum>(); auto destination = read<GLenum>();
+			glBlendFunc(source, destination);
+			break;
+		}
+		case CaptureOp::DepthFunc:
+			glDepthFunc(read<GLenum>());
+			break;
+		case CaptureOp::PixelStorei: {
+			auto pname = read<GLenum>(); auto param = read<GLint>();
+			if (pname == GL_UNPACK_ALIGNMENT) {
+				unpackAlignment = param;
+			}
+			glPixelStorei(pname, param);
+			break;
+		}
+
+		case CaptureOp::ActiveTexture:
+			glActiveTexture(read<GLenum>());
+			break;
+		case CaptureOp::GenTextures:
+			generate(textures, glGenTextures);
+			break;
+		case CaptureOp::DeleteTextures:
+			destroy(textures, glDeleteTextures);
+			break;
+		case CaptureOp::BindTexture: {
+			auto target = read<GLenum>(); auto texture = read<GLuint>();
+			glBindTexture(target, map(textures, texture));
+			break;
+		}
+		case CaptureOp::TexParameteri: {
+			auto target = read<GLenum>(); auto pname = read<GLenum>(); auto param = read<GLint>();
+			glTexParameteri(target, pname, param);
+			break;
+		}
+		case CaptureOp::TexImage2D: {
+			auto target = read<GLenum>(); auto level = read<GLint>(); auto internalformat = read<GLint>();
+			auto w = read<GLsizei>(); auto h = read<GLsizei>(); auto border = read<GLint>();
+			auto format = read<GLenum>(); auto type = read<GLenum>();
+			glTexImage2D(target, level, internalformat, w, h, border, format, type, pixels(w, h, format, type));
+			break;
+		}
+		case CaptureOp::TexSubImage2D: {
+			auto target = read<GLenum>(); auto level = read<GLint>(); auto x = read<GLint>(); auto y = read<GLint>();
+			auto w = read<GLsizei>(); auto h = read<GLsizei>(); auto format = read<GLenum>(); auto type = read<GLenum>();
+			glTexSubImage2D(target, level, x, y, w, h, format, type, pixels(w, h, format, type));
+			break;
+		}
+		case CaptureOp::GenerateMipmap:
+			glGenerateMipmap(read<GLenum>());
+			break;
+
+		case CaptureOp::GenBuffers:
+			generate(buffers, glGenBuffers);
+			break;
+		case CaptureOp::DeleteBuffers:
+			destroy(buffers, glDeleteBuffers);
+			break;
+		case CaptureOp::BindBuffer: {
+			auto target = read<GLenum>(); auto buffer = read<GLuint>();
+			glBindBuffer(target, map(buffers, buffer));
+			break;
+		}
+		case CaptureOp::BufferData: {
+			auto target = read<GLenum>(); auto size = read<int64_t>(); auto usage = read<GLenum>();
+			auto bytes = blob(uint64_t(size), true);
+			glBufferData(target, GLsizeiptr(size), bytes, usage);
+			break;
+		}
+		case CaptureOp::BufferSubData: {
+			auto target = read<GLenum>(); auto offset = read<int64_t>(); auto size = read<int64_t>();
+			auto bytes = blob(uint64_t(size), false);
+			glBufferSubData(target, GLintptr(offset), GLsizeiptr(size), bytes);
+			break;
+		}
+		case CaptureOp::BindBufferRange: {
+			auto target = read<GLenum>(); auto index = read<GLuint>(); auto buffer = read<GLuint>();
+			auto offset = read<int64_t>(); auto size = read<int64_t>();
+			glBindBufferRange(target, index, map(buffers, buffer), GLintptr(offset), GLsizeiptr(size));
+			break;
+		}
+		case CaptureOp::BindBufferBase: {
+			auto target = read<GLenum>(); auto index = read<GLuint>(); auto buffer = read<GLuint>();
+			glBindBufferBase(target, index, map(buffers, buffer));
+			break;
+		}
+
+		case CaptureOp::GenVertexArrays:
+			generate(vertexArrays, glGenVertexArrays);
+			break;
+		case CaptureOp::DeleteVertexArrays:
+			destroy(vertexArrays, glDeleteVertexArrays);
+			break;
+		case CaptureOp::BindVertexArray:
+			glBindVertexArray(map(vertexArrays, read<GLuint>()));
+			break;
+		case CaptureOp::VertexAttribPointer: {
+			auto index = read<GLuint>(); auto size = read<GLint>(); auto type = read<GLenum>();
+			auto normalized = read<GLboolean>(); auto stride = read<GLsizei>(); auto offset = read<uint64_t>();
+			glVertexAttribPointer(index, size, type, normalized, stride, pointer(offset));
+			break;
+		}
+		case CaptureOp::VertexAttribIPointer: {
+			auto index = read<GLuint>(); auto size = read<GLint>(); auto type = read<GLenum>();
+			auto stride = read<GLsizei>(); auto offset = read<uint64_t>();
+			glVertexAttribIPointer(index, size, type, stride, pointer(offset));
+			break;
+		}
+		case CaptureOp::EnableVertexAttribArray:
+			glEnableVertexAttribArray(read<GLuint>());
+			break;
+		case CaptureOp::DisableVertexAttribArray:
+			glDisableVertexAttribArray(read<GLuint>());
+			break;
+		case CaptureOp::VertexAttribDivisor: {
+			auto index = read<GLuint>(); auto divisor = read<GLuint>();
+			glVertexAttribDivisor(index, divisor);
+			break;
+		}
+
+		case CaptureOp::CreateShader: {
+			auto type = read<GLenum>(); auto shader = read<GLuint>();
+			programs[shader] = glCreateShader(type);
+			break;
+		}
+		case CaptureOp::ShaderSource: {
+			auto shader = read<GLuint>(); auto count = read<GLsizei>();
+			if (count < 0) {
+				throw TruncatedCapture();
+			}
+			std::vector<const GLchar*> strings(count);
+			std::vector<GLint> lengths(count);
+			for (GLsizei i = 0; i < count; i++) {
+				uint64_t size;
+				strings[i] = blob(size);
+				lengths[i] = GLint(size);
+			}
+			glShaderSource(map(programs, shader), count, strings.data(), lengths.data());
+			break;
+		}
+		case CaptureOp::CompileShader:
+			glCompileShader(map(programs, read<GLuint>()));
+			break;
+		case CaptureOp::DeleteShader:
+			glDeleteShader(map(programs, read<GLuint>()));
+			break;
+		case CaptureOp::CreateProgram:
+			programs[read<GLuint>()] = glCreateProgram();
+			break;
+		case CaptureOp::AttachShader: {
+			auto p = read<GLuint>(); auto shader = read<GLuint>();
+			glAttachShader(map(programs, p), map(programs, shader));
+			break;
+		}
+		case CaptureOp::DetachShader: {
+			auto p = read<GLuint>(); auto shader = read<GLuint>();
+			glDetachShader(map(programs, p), map(programs, shader));
+			break;
+		}
+		case CaptureOp::LinkProgram:
+			glLinkProgram(map(programs, read<GLuint>()));
+			break;
+		case CaptureOp::DeleteProgram:
+			glDeleteProgram(map(programs, read<GLuint>()));
+			break;
+		case CaptureOp::UseProgram:
+			program = read<GLuint>();
+			glUseProgram(map(programs, program));
+			break;
+		case CaptureOp::GetUniformLocation: {
+			auto p = read<GLuint>(); auto captured = read<GLint>();
+			uint64_t size;
+			auto name = blob(size);
+			locations[std::make_pair(p, captured)] = glGetUniformLocation(map(programs, p), std::string(name, size).c_str());
+			break;
+		}
+		case CaptureOp::Uniform1i: {
+			auto loc = location(read<GLint>()); auto v0 = read<GLint>();
+			glUniform1i(loc, v0);
+			break;
+		}
+		case CaptureOp::Uniform1f: {
+			auto loc = location(read<GLint>()); auto v0 = read<GLfloat>();
+			glUniform1f(loc, v0);
+			break;
+		}
+		case CaptureOp::Uniform2f: {
+			auto loc = location(read<GLint>()); auto v0 = read<GLfloat>(); auto v1 = read<GLfloat>();
+			glUniform2f(loc, v0, v1);
+			break;
+		}
+		case CaptureOp::Uniform3f: {
+			auto loc = location(read<GLint>()); auto v0 = read<GLfloat>(); auto v1 = read<GLfloat>(); auto v2 = read<GLfloat>();
+			glUniform3f(loc, v0, v1, v2);
+			break;
+		}
+		case CaptureOp::Uniform4f: {
+			auto loc = location(read<GLint>()); auto v0 = read<GLfloat>(); auto v1 = read<GLfloat>();
+			auto v2 = read<GLfloat>(); auto v3 = read<GLfloat>();
+			glUniform4f(loc, v0, v1, v2, v3);
+			break;
+		}
+		case CaptureOp::Uniform1iv: {
+			auto loc = location(read<GLint>()); auto count = read<GLsizei>();
+			auto values = array<GLint>(int64_t(count) * 1);
+			glUniform1iv(loc, count, values.data());
+			break;
+		}
+		case CaptureOp::Uniform1fv: {
+			auto loc = location(read<GLint>()); auto count = read<GLsizei>();
+			auto values = array<GLfloat>(int64_t(count) * 1);
+			glUniform1fv(loc, count, values.data());
+			break;
+		}
+		case CaptureOp::Uniform2fv: {
+			auto loc = location(read<GLint>()); auto count = read<GLsizei>();
+			auto values = array<GLfloat>(int64_t(count) * 2);
+			glUniform2fv(loc, count, values.data());
+			break;
+		}
+		case CaptureOp::Uniform3fv: {
+			auto loc = location(read<GLint>()); auto count = read<GLsizei>();
+			auto values = array<GLfloat>(int64_t(count) * 3);
+			glUniform3fv(loc, count, values.data());
+			break;
+		}
+		case CaptureOp::Uniform4fv: {
+			auto loc = location(read<GLint>()); auto count = read<GLsizei>();
+			auto values = array<GLfloat>(int64_t(count) * 4);
+			glUniform4fv(loc, count, values.data());
+			break;
+		}
+		case CaptureOp::UniformMatrix3fv: {
+			auto loc = location(read<GLint>()); auto count = read<GLsizei>(); auto transpose = read<GLboolean>();
+			auto values = array<GLfloat>(int64_t(count) * 9);
+			glUniformMatrix3fv(loc, count, transpose, values.data());
+			break;
+		}
+		case CaptureOp::UniformMatrix4fv: {
+			auto loc = location(read<GLint>()); auto count = read<GLsizei>(); auto transpose = read<GLboolean>();
+			auto values = array<GLfloat>(int64_t(count) * 16);
+			glUniformMatrix4fv(loc, count, transpose, values.data());
+			break;
+		}
+
+		case CaptureOp::DrawArrays: {
+			auto mode = read<GLenum>(); auto first = read<GLint>(); auto count = read<GLsizei>();
+			glDrawArrays(mode, first, count);
+			break;
+		}
+		case CaptureOp::DrawElements: {
+			auto mode = read<GLenum>(); auto count = read<GLsizei>(); auto type = read<GLenum>(); auto offset = read<uint64_t>();
+			glDrawElements(mode, count, type, pointer(offset));
+			break;
+		}
+		case CaptureOp::DrawArraysInstanced: {
+			auto mode = read<GLenum>(); auto first = read<GLint>(); auto count = read<GLsizei>(); auto instances = read<GLsizei>();
+			glDrawArraysInstanced(mode, first, count, instances);
+			break;
+		}
+		case CaptureOp::DrawElementsInstanced: {
+			auto mode = read<GLenum>(); auto count = read<GLsizei>(); auto type = read<GLenum>();
+			auto offset = read<uint64_t>(); auto instances = read<GLsizei>();
+			glDrawElementsInstanced(mode, count, type, pointer(offset), instances);
+			break;
+		}
+		case CaptureOp::DrawElementsBaseVertex: {
+			auto mode = read<GLenum>(); auto count = read<GLsizei>(); auto type = read<GLenum>();
+			auto offset = read<uint64_t>(); auto baseVertex = read<GLint>();
+			glDrawElementsBaseVertex(mode, count, type, pointer(offset), baseVertex);
+			break;
+		}
+		case CaptureOp::MultiDrawElementsBaseVertex: {
+			auto mode = read<GLenum>(); auto type = read<GLenum>(); auto drawcount = read<GLsizei>();
+			auto counts = array<GLsizei>(drawcount);
+			auto offsets = array<uint64_t>(drawcount);
+			auto baseVertices = array<GLint>(drawcount);
+			std::vector<const void*> indices(drawcount);
+			for (GLsizei i = 0; i < drawcount; i++) {
+				indices[i] = pointer(offsets[i]);
+			}
+			glMultiDrawElementsBaseVertex(mode, counts.data(), type, indices.data(), drawcount, baseVertices.data());
+			break;
+		}
+
+		case CaptureOp::GenFramebuffers:
+			generate(framebuffers, glGenFramebuffers);
+			break;
+		case CaptureOp::DeleteFramebuffers:
+			destroy(framebuffers, glDeleteFramebuffers);
+			break;
+		case CaptureOp::BindFramebuffer: {
+			auto target = read<GLenum>(); auto framebuffer = read<GLuint>();
+			glBindFramebuffer(target, map(framebuffers, framebuffer));
+			break;
+		}
+		case CaptureOp::FramebufferTexture2D: {
+			auto target = read<GLenum>(); auto attachment = read<GLenum>(); auto textarget = read<GLenum>();
+			auto texture = read<GLuint>(); auto level = read<GLint>();
+			glFramebufferTexture2D(target, attachment, textarget, map(textures, texture), level);
+			break;
+		}
+		case CaptureOp::FramebufferRenderbuffer: {
+			auto target = read<GLenum>(); auto attachment = read<GLenum>(); auto rbtarget = read<GLenum>();
+			auto renderbuffer = read<GLuint>();
+			glFramebufferRenderbuffer(target, attachment, rbtarget, map(renderbuffers, renderbuffer));
+			break;
+		}
+		case CaptureOp::GenRenderbuffers:
+			generate(renderbuffers, glGenRenderbuffers);
+			break;
+		case CaptureOp::DeleteRenderbuffers:
+			destroy(renderbuffers, glDeleteRenderbuffers);
+			break;
+		case CaptureOp::BindRenderbuffer: {
+			auto target = read<GLenum>(); auto renderbuffer = read<GLuint>();
+			glBindRenderbuffer(target, map(renderbuffers, renderbuffer));
+			break;
+		}
+		case CaptureOp::RenderbufferStorage: {
+			auto target = read<GLenum>(); auto internalformat = read<GLenum>();
+			auto w = read<GLsizei>(); auto h = read<GLsizei>();
+			glRenderbufferStorage(target, internalformat, w, h);
+			break;
+		}
+		case CaptureOp::BlitFramebuffer: {
+			GLint c[8];
+			for (auto& v : c) {
+				v = read<GLint>();
+			}
+			auto mask = read<GLbitfield>(); auto filter = read<GLenum>();
+			glBlitFramebuffer(c[0], c[1], c[2], c[3], c[4], c[5], c[6], c[7], mask, filter);
+			break;
+		}
+
+		default:
+			return false;
+		}
+		return true;
+	}
+};
+
+// replay capture.bin [--loops N] [--headless]
+int main(int argc, char** argv) {
+	if (argc < 2) {
+		std::cout << "Usage: replay capture.bin [--loops N] [--headless]" << std::endl;
+		return -1;
+	}
+
+	int loops = 10;
+	bool headless = false;
+	for (int i = 2; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "--loops" && i + 1 < argc) {
+			loops = std::atoi(argv[++i]);
+		}
+		else if (arg == "--headless") {
+			headless = true;
+		}
+	}
+
+	std::ifstream file(argv[1], std::ios::binary);
+	std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	Replayer replayer(data);
+	if (!replayer.readHeader()) {
+		std::cout << "Not a capture, " << argv[1] << std::endl;
+		return -1;
+	}
+
+	GLFWwindow* win = initWindow(headless);
+	if (win == NULL) {
+		return -1;
+	}
+	glfwSwapInterval(0);
+
+	// Everything up to the first frame marker is setup and runs once; the
+	// frames after it are replayed loops times.
+	replayer.runFrame();
+	glFinish();
+	size_t firstFrame = replayer.position();
+
+	FrameClock clock;
+	for (int loop = 0; loop < loops && !glfwWindowShouldClose(win); loop++) {
+		replayer.seek(firstFrame);
+
+		int frames = 0;
+		double total = 0, best = 1e9, worst = 0;
+		while (!replayer.done()) {
+			clock.tick();
+			if (!replayer.runFrame()) {
+				break;
+			}
+			glFinish();
+			double frame = clock.tick();
+
+			frames++;
+			total += frame;
+			best = frame < best ? frame : best;
+			worst = frame > worst ? frame : worst;
+
+			glfwSwapBuffers(win);
+			glfwPollEvents();
+		}
+
+		if (frames > 0) {
+			std::cout << "Loop " << loop << ", " << frames << " frames\t" << total * 1000 / frames << "ms avg, "
+				<< best * 1000 << "-" << worst * 1000 << "ms" << std::endl;
+		}
+	}
+
+	glfwTerminate();
+	return 0;
+}